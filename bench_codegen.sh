@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Times the parser generated by Task 11 against the table-driven parse of
+# Task 12 on the same sentences.
+#
+# Usage: ./bench_codegen.sh grammar [length] [count] [seed]
+
+if [ "$#" -lt "1" ]; then
+    echo "Usage: $0 grammar [length] [count] [seed]"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+grammar=$1
+length=${2:-20}
+count=${3:-1000000}
+seed=${4:-1}
+
+work=$(mktemp -d)
+trap 'rm -rf ${work}' EXIT
+
+./a.out 11 < ${grammar} > ${work}/parser.cpp
+if grep -q "^Error" ${work}/parser.cpp; then
+    cat ${work}/parser.cpp
+    exit 1
+fi
+
+./a.out 15 --length=${length} --count=${count} --seed=${seed} < ${grammar} > ${work}/sentences
+echo "$(wc -l < ${work}/sentences) sentences, $(wc -c < ${work}/sentences) bytes"
+
+${CXX} -std=c++11 -O2 -DGENERATED_PARSER_MAIN ${work}/parser.cpp -o ${work}/parser || exit 1
+
+echo -n "generated:    "
+${work}/parser < ${work}/sentences 2>&1 > /dev/null | tail -1
+echo -n "table-driven: "
+./a.out 12 --sentences=${work}/sentences < ${grammar} 2>&1 > /dev/null | tail -1
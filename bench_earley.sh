@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# Reports the throughput of the general (Earley) parse of Task 14, next to
+# the table-driven LL(1) parse of Task 12 and the DFA of Task 17 where the
+# grammar allows them.
+#
+# Usage: ./bench_earley.sh [length] [count] [seed] [grammar...]
+# With no grammars, every grammar under tests/ is measured.
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+length=${1:-20}
+count=${2:-200000}
+seed=${3:-1}
+shift 3 2> /dev/null
+grammars=${@:-$(find "./tests" -type f -name "*.txt" | sort)}
+threads=${THREADS:+--threads=${THREADS}}
+
+work=$(mktemp -d)
+trap 'rm -rf ${work}' EXIT
+
+for grammar in ${grammars}; do
+    name=`basename ${grammar} .txt`
+    ./a.out 15 --length=${length} --count=${count} --seed=${seed} < ${grammar} > ${work}/sentences
+    if grep -q "^Error" ${work}/sentences; then
+        echo "${name}: no sentences, skipped"
+        continue
+    fi
+
+    echo "${name}:"
+    echo -n "  earley: "
+    ./a.out 14 ${threads} --sentences=${work}/sentences < ${grammar} 2>&1 > /dev/null | tail -1
+    if ./a.out 12 --sentences=${work}/sentences < ${grammar} 2>&1 > ${work}/ll1 | tail -1 > ${work}/ll1.time &&
+        ! grep -q "^Error" ${work}/ll1; then
+        echo -n "  ll1:    "
+        cat ${work}/ll1.time
+    fi
+    ./a.out 17 ${threads} --sentences=${work}/sentences < ${grammar} 2> ${work}/dfa.time > ${work}/dfa
+    if ! grep -q "^Error" ${work}/dfa; then
+        echo -n "  dfa:    "
+        tail -1 ${work}/dfa.time
+    fi
+done
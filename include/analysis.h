@@ -1,5 +1,6 @@
 #pragma once
 #include "types.h"
+#include <iostream>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -12,54 +13,87 @@ using SetMap = std::unordered_map<std::string, std::unordered_set<std::string>>;
 using RuleMap = std::unordered_map<string, unordered_set<Rule, RuleHasher>>;
 namespace analysis {
 // Task 2
-auto print_nullable_set(const Grammar &grammar) -> void;
+auto print_nullable_set(const Grammar &grammar, std::ostream &out = std::cout)
+    -> void;
 auto calc_nullable(const Grammar &grammar) -> unordered_set<std::string>;
 
 // Task 3
-auto print_first_sets(const Grammar &grammar) -> void;
+auto print_first_sets(const Grammar &grammar, std::ostream &out = std::cout)
+    -> void;
 auto calc_first(const Grammar &grammar) -> SetMap;
-auto first_of_subset(const std::vector<std::string> &symbols,
-                     const size_t start_idx, const SetMap &first,
-                     const std::unordered_set<std::string> &nullable)
-    -> std::unordered_set<std::string>;
 
 // Task 4
-auto print_follow_sets(const Grammar &grammar) -> void;
+auto print_follow_sets(const Grammar &grammar, std::ostream &out = std::cout)
+    -> void;
 auto calc_follow(const Grammar &grammar) -> SetMap;
 
 // Task 5
-auto print_left_factored_grammar(const Grammar &grammar) -> void;
+auto print_left_factored_grammar(const Grammar &grammar,
+                                 std::ostream &out = std::cout) -> void;
 auto calc_left_factored(Grammar grammar) -> std::vector<Rule>;
+auto calc_left_factored_sequential(Grammar grammar) -> std::vector<Rule>;
+/*
+ * --factor=conflicts: factors only prefixes shared by two alternatives whose
+ * predict sets (FIRST of the rhs, plus epsilon when it is all nullable)
+ * overlap, longest first as in calc_left_factored. The new nonterminal's
+ * alternatives are checked the same way. Prefixes an LL(1) parser can
+ * already see past, such as A -> M a | M b with M -> epsilon, are kept.
+ */
+auto calc_left_factored_conflicts(Grammar grammar) -> std::vector<Rule>;
+auto left_factor_conflicts_non_term(const string &non_term,
+                                    unordered_set<Rule, RuleHasher> rules,
+                                    const SetMap &first,
+                                    const unordered_set<string> &nullable,
+                                    const unordered_set<string> &non_terms,
+                                    vector<string> &new_nts) -> vector<Rule>;
+auto left_factor_non_term(const string &non_term,
+                          unordered_set<Rule, RuleHasher> rules,
+                          vector<string> &new_nts) -> vector<Rule>;
 auto longest_shared_prefix(const unordered_set<Rule, RuleHasher> &rules)
     -> vector<string>;
 auto postfix_of_rules_with_prefix(const unordered_set<Rule, RuleHasher> &rules,
                                   const vector<string> &prefix)
     -> vector<vector<string>>;
-auto all_rules_that_start_with(const vector<string> &prefix,
-                               const unordered_set<Rule, RuleHasher> &rules)
-    -> vector<Rule>;
+// Erases in place, so the rules are never copied
+auto erase_rules_that_start_with(const vector<string> &prefix,
+                                 unordered_set<Rule, RuleHasher> &rules)
+    -> void;
 
 // Task 6
-auto print_grammar_without_left_recursion(const Grammar &grammar) -> void;
+auto print_grammar_without_left_recursion(const Grammar &grammar,
+                                          std::ostream &out = std::cout)
+    -> void;
 auto eliminate_left_recursion(Grammar grammar) -> vector<Rule>;
 
-auto split_by_left_recurse(const unordered_set<Rule, RuleHasher> &rules)
+auto split_by_left_recurse(unordered_set<Rule, RuleHasher> &&rules)
     -> std::pair<vector<Rule>, vector<Rule>>;
-auto replace_nt_for_rhs(const Rule &rule, const string &nt_to_replace,
+// Consumes rule: the last replacement takes its lhs and the rest of its rhs
+auto replace_nt_for_rhs(Rule &&rule, const string &nt_to_replace,
                         const unordered_set<Rule, RuleHasher> &nt_rules)
     -> vector<Rule>;
 auto generate_recursed_new_nt_rules(const vector<Rule> &recurse_rules,
                                     const string &new_nt)
     -> unordered_set<Rule, RuleHasher>;
 
+// Task 10
+auto print_reduced_grammar(const Grammar &grammar,
+                           std::ostream &out = std::cout) -> void;
+auto remove_useless_symbols(const Grammar &grammar) -> Grammar;
+
 // Util
 auto all_nullable(const std::vector<std::string> &symbols,
                   const std::unordered_set<std::string> &nullable) -> bool;
 auto print_set_map(const SetMap &map, const Grammar &grammar,
-                   const std::string &set_name) -> void;
+                   const std::string &set_name, std::ostream &out = std::cout)
+    -> void;
 
+// The && overloads move the rules instead of copying them
 auto gen_rule_map(const vector<Rule> &rules) -> RuleMap;
-auto print_rules(vector<Rule> &rules) -> void;
+auto gen_rule_map(vector<Rule> &&rules) -> RuleMap;
+auto print_rules(vector<Rule> &rules, std::ostream &out = std::cout) -> void;
+auto print_rule(const Rule &rule, std::ostream &out = std::cout) -> void;
 auto rule_map_to_vec(const RuleMap &rule_map) -> vector<Rule>;
+auto rule_map_to_vec(RuleMap &&rule_map) -> vector<Rule>;
+auto grammar_from_rules(vector<Rule> rules) -> Grammar;
 
 } // namespace analysis
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-size bitset sized at runtime, for sets over dense symbol ids
+class Bitset {
+  public:
+    Bitset() = default;
+    explicit Bitset(size_t size) : words((size + 63) / 64, 0) {}
+
+    auto set(size_t bit) -> void {
+        words[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    auto test(size_t bit) const -> bool {
+        return ((words[bit / 64] >> (bit % 64)) & 1) != 0;
+    }
+
+    // Returns true if any bit was added
+    auto merge(const Bitset &other) -> bool {
+        bool changed = false;
+        for (size_t i = 0; i < words.size(); i++) {
+            uint64_t merged = words[i] | other.words[i];
+            changed = changed || merged != words[i];
+            words[i] = merged;
+        }
+        return changed;
+    }
+
+    auto intersects(const Bitset &other) const -> bool {
+        for (size_t i = 0; i < words.size(); i++) {
+            if ((words[i] & other.words[i]) != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls fn(bit) for every set bit in increasing order
+    template <typename Fn> auto for_each(Fn fn) const -> void {
+        for (size_t i = 0; i < words.size(); i++) {
+            uint64_t word = words[i];
+            while (word != 0) {
+                fn(i * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+
+  private:
+    std::vector<uint64_t> words;
+};
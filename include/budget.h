@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+// Limits for one run of a task. 0 means no limit.
+struct Budget {
+    double max_ms = 0;
+    size_t max_rules = 0; // rules created by the grammar transforms
+    size_t max_bytes = 0; // bytes of those rules, as an arena would hold them
+
+    auto limited() const -> bool {
+        return max_ms > 0 || max_rules > 0 || max_bytes > 0;
+    }
+};
+
+// Thrown from inside an analysis once its run's budget is spent. what() is
+// the progress report, e.g. "time budget of 100 ms exceeded at left
+// recursion nonterminal 12 of 40 (5300 rules, 424000 bytes, 100.2 ms)".
+struct BudgetExceeded : std::runtime_error {
+    explicit BudgetExceeded(const std::string &report)
+        : std::runtime_error(report) {}
+};
+
+const int BUDGET_EXCEEDED_EXIT = 3;
+
+namespace budget {
+
+// What one run has used so far, shared by the threads working on it
+struct RunState {
+    Budget budget;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<size_t> rules{0};
+    std::atomic<size_t> bytes{0};
+};
+
+// The calling thread's run, or nullptr when nothing is limited
+auto current() -> RunState *;
+
+// Limits every analysis on this thread, and in the parallel_for workers it
+// starts, until destroyed. Runs on other threads are unaffected.
+class Scope {
+  public:
+    explicit Scope(const Budget &budget);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    auto operator=(const Scope &) -> Scope & = delete;
+
+  private:
+    RunState state;
+    RunState *previous;
+};
+
+// Makes a worker thread count against the run that started it
+class Join {
+  public:
+    explicit Join(RunState *state);
+    ~Join();
+    Join(const Join &) = delete;
+    auto operator=(const Join &) -> Join & = delete;
+
+  private:
+    RunState *previous;
+};
+
+// Cooperative checks, cheap when no budget is set. step, done and total
+// describe the progress: "left recursion nonterminal", 12, 40. A total of
+// 0 means unknown ("FIRST pass 3").
+auto check(const char *step, size_t done, size_t total) -> void;
+
+// check() for tight loops: reads the clock only every POLL_INTERVAL calls
+const size_t POLL_INTERVAL = 1024;
+auto poll(const char *step, size_t done, size_t total) -> void;
+
+// Records rules created by a transform, then checks the budget
+auto charge(size_t rules, size_t bytes, const char *step, size_t done,
+            size_t total) -> void;
+
+} // namespace budget
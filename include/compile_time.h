@@ -0,0 +1,511 @@
+#pragma once
+// Header-only constexpr mirror of analysis::calc_nullable, calc_first,
+// calc_follow and ll1::build_table for small grammars embedded in C++
+// sources. Requires C++17. Storage is fixed-capacity arrays sized from the
+// grammar text, so a grammar written as a constexpr literal gets its tables
+// computed by the compiler:
+//
+//     static constexpr char text[] = "S -> a S b | * #";
+//     constexpr auto tables = compile_time::analyze<text>();
+//     static_assert(tables.is_ll1(), "");
+//
+// The text uses the BNF subset of the a.out input format (no EBNF
+// operators) and a malformed grammar fails to compile. Symbol ids follow
+// InternedGrammar: terminals take [0, num_terms) in term_order, nonterminals
+// follow in non_term_order. In FOLLOW sets and LL(1) lookaheads column
+// num_terms stands for $.
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+
+namespace compile_time {
+
+// Bitset over symbol ids (plus $); std::bitset is not constexpr until C++23
+template <size_t N> class SymbolSet {
+  public:
+    constexpr auto test(size_t i) const -> bool { return bits[i]; }
+
+    // Returns whether i was newly added
+    constexpr auto set(size_t i) -> bool {
+        bool added = !bits[i];
+        bits[i] = true;
+        return added;
+    }
+
+    // Returns whether anything was added
+    constexpr auto merge(const SymbolSet &other) -> bool {
+        bool changed = false;
+        for (size_t i = 0; i < N; i++) {
+            if (other.bits[i] && !bits[i]) {
+                bits[i] = true;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+  private:
+    std::array<bool, N> bits{};
+};
+
+namespace detail {
+
+enum class TokenType { END_OF_FILE, ARROW, STAR, HASH, ID, ERROR, OR };
+
+struct Token {
+    TokenType type;
+    std::string_view lexeme;
+};
+
+constexpr auto is_space(char c) -> bool {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+           c == '\v';
+}
+constexpr auto is_alpha(char c) -> bool {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+constexpr auto is_alnum(char c) -> bool {
+    return is_alpha(c) || (c >= '0' && c <= '9');
+}
+
+// BNF tokens of LexicalAnalyzer
+class Lexer {
+  public:
+    constexpr explicit Lexer(std::string_view text) : text(text) {}
+
+    constexpr auto next() -> Token { return scan(pos); }
+    constexpr auto peek() const -> Token {
+        size_t ahead = pos;
+        return scan(ahead);
+    }
+
+  private:
+    std::string_view text;
+    size_t pos = 0;
+
+    constexpr auto scan(size_t &p) const -> Token {
+        while (p < text.size() && is_space(text[p])) {
+            p++;
+        }
+        if (p == text.size()) {
+            return Token{TokenType::END_OF_FILE, {}};
+        }
+
+        char c = text[p++];
+        switch (c) {
+        case '-':
+            if (p < text.size() && text[p] == '>') {
+                p++;
+                return Token{TokenType::ARROW, {}};
+            }
+            return Token{TokenType::ERROR, {}};
+        case '#':
+            return Token{TokenType::HASH, {}};
+        case '*':
+            return Token{TokenType::STAR, {}};
+        case '|':
+            return Token{TokenType::OR, {}};
+        default:
+            break;
+        }
+        if (!is_alpha(c)) {
+            return Token{TokenType::ERROR, {}};
+        }
+        size_t start = p - 1;
+        while (p < text.size() && is_alnum(text[p])) {
+            p++;
+        }
+        return Token{TokenType::ID, text.substr(start, p - start)};
+    }
+};
+
+// Throwing during constant evaluation turns a syntax error into a compile
+// error
+constexpr auto expect(Lexer &lexer, TokenType type) -> Token {
+    Token token = lexer.next();
+    if (token.type != type) {
+        throw std::invalid_argument("SYNTAX ERROR !!!!!!!!!!!!!!");
+    }
+    return token;
+}
+
+} // namespace detail
+
+// Upper bounds on the sizes a grammar text needs
+struct Capacity {
+    size_t symbols = 1;
+    size_t rules = 1;
+    size_t rhs = 1;
+};
+
+constexpr auto measure(std::string_view text) -> Capacity {
+    Capacity capacity;
+    size_t ids = 0;
+    size_t rules = 0;
+    size_t rhs = 0;
+    bool after_arrow = false;
+
+    detail::Lexer lexer(text);
+    detail::Lexer seen(text);
+    for (detail::Token token = lexer.next();
+         token.type != detail::TokenType::END_OF_FILE; token = lexer.next()) {
+        switch (token.type) {
+        case detail::TokenType::ID: {
+            // Count distinct names by checking earlier occurrences
+            bool repeated = false;
+            seen = detail::Lexer(text);
+            for (size_t i = 0; i < ids && !repeated; i++) {
+                detail::Token earlier = seen.next();
+                while (earlier.type != detail::TokenType::ID) {
+                    earlier = seen.next();
+                }
+                repeated = earlier.lexeme == token.lexeme;
+            }
+            ids++;
+            if (!repeated) {
+                capacity.symbols++;
+            }
+            rhs += after_arrow ? 1 : 0;
+            break;
+        }
+        case detail::TokenType::ARROW:
+            after_arrow = true;
+            rhs = 0;
+            break;
+        case detail::TokenType::OR:
+        case detail::TokenType::STAR:
+            rules++;
+            capacity.rhs = rhs > capacity.rhs ? rhs : capacity.rhs;
+            rhs = 0;
+            after_arrow = token.type == detail::TokenType::OR;
+            break;
+        default:
+            break;
+        }
+    }
+    capacity.rules = rules > 0 ? rules : 1;
+    return capacity;
+}
+
+template <size_t MaxSymbols, size_t MaxRules, size_t MaxRhs>
+struct StaticGrammar {
+    std::array<std::string_view, MaxSymbols> names{};
+    size_t num_symbols = 0;
+    size_t num_terms = 0;
+
+    // Rules keep file order, like Grammar::rules
+    size_t num_rules = 0;
+    std::array<size_t, MaxRules> rule_lhs{};
+    std::array<std::array<size_t, MaxRhs>, MaxRules> rule_rhs{};
+    std::array<size_t, MaxRules> rule_size{};
+
+    constexpr auto is_term(size_t symbol) const -> bool {
+        return symbol < num_terms;
+    }
+    constexpr auto start() const -> size_t { return num_terms; }
+
+    // Returns num_symbols for an unknown name
+    constexpr auto id(std::string_view name) const -> size_t {
+        for (size_t i = 0; i < num_symbols; i++) {
+            if (names[i] == name) {
+                return i;
+            }
+        }
+        return num_symbols;
+    }
+};
+
+// Mirrors Parser: universe order is first appearance, nonterminals are the
+// names that appear on a left-hand side
+template <size_t MaxSymbols, size_t MaxRules, size_t MaxRhs>
+constexpr auto parse_grammar(std::string_view text)
+    -> StaticGrammar<MaxSymbols, MaxRules, MaxRhs> {
+    using detail::TokenType;
+
+    std::array<std::string_view, MaxSymbols> universe{};
+    std::array<bool, MaxSymbols> is_non_term{};
+    size_t universe_size = 0;
+    auto update_universe = [&](std::string_view name) -> size_t {
+        for (size_t i = 0; i < universe_size; i++) {
+            if (universe[i] == name) {
+                return i;
+            }
+        }
+        universe[universe_size] = name;
+        return universe_size++;
+    };
+
+    // Rules over universe indices first; ids are only known at the end
+    StaticGrammar<MaxSymbols, MaxRules, MaxRhs> grammar;
+    detail::Lexer lexer(text);
+    do {
+        size_t lhs =
+            update_universe(detail::expect(lexer, TokenType::ID).lexeme);
+        is_non_term[lhs] = true;
+        detail::expect(lexer, TokenType::ARROW);
+        while (true) {
+            size_t rule = grammar.num_rules++;
+            grammar.rule_lhs[rule] = lhs;
+            while (lexer.peek().type == TokenType::ID) {
+                grammar.rule_rhs[rule][grammar.rule_size[rule]++] =
+                    update_universe(lexer.next().lexeme);
+            }
+            if (lexer.peek().type != TokenType::OR) {
+                break;
+            }
+            lexer.next();
+        }
+        detail::expect(lexer, TokenType::STAR);
+    } while (lexer.peek().type == TokenType::ID);
+    detail::expect(lexer, TokenType::HASH);
+    detail::expect(lexer, TokenType::END_OF_FILE);
+
+    std::array<size_t, MaxSymbols> ids{};
+    for (size_t i = 0; i < universe_size; i++) {
+        if (!is_non_term[i]) {
+            ids[i] = grammar.num_terms++;
+        }
+    }
+    size_t next_id = grammar.num_terms;
+    for (size_t i = 0; i < universe_size; i++) {
+        if (is_non_term[i]) {
+            ids[i] = next_id++;
+        }
+    }
+    for (size_t i = 0; i < universe_size; i++) {
+        grammar.names[ids[i]] = universe[i];
+    }
+    grammar.num_symbols = universe_size;
+
+    for (size_t r = 0; r < grammar.num_rules; r++) {
+        grammar.rule_lhs[r] = ids[grammar.rule_lhs[r]];
+        for (size_t i = 0; i < grammar.rule_size[r]; i++) {
+            grammar.rule_rhs[r][i] = ids[grammar.rule_rhs[r][i]];
+        }
+    }
+    return grammar;
+}
+
+template <size_t MaxSymbols, size_t MaxRules, size_t MaxRhs>
+struct StaticTables {
+    using Grammar = StaticGrammar<MaxSymbols, MaxRules, MaxRhs>;
+    using Set = SymbolSet<MaxSymbols + 1>;
+
+    Grammar grammar;
+    Set nullable;
+    std::array<Set, MaxSymbols> first{};
+    std::array<Set, MaxSymbols> follow{};
+
+    // Rule per (nt - num_terms, lookahead), -1 for an error. A cell claimed
+    // by several rules keeps the first one, as in LL1Table.
+    std::array<std::array<int, MaxSymbols + 1>, MaxSymbols> ll1{};
+    size_t ll1_conflicts = 0;
+
+    constexpr auto end_marker() const -> size_t { return grammar.num_terms; }
+    constexpr auto is_ll1() const -> bool { return ll1_conflicts == 0; }
+    constexpr auto entry(size_t nt, size_t lookahead) const -> int {
+        return ll1[nt - grammar.num_terms][lookahead];
+    }
+
+    // FIRST of rule's rhs from position start (SuffixFirstTable::at)
+    constexpr auto first_of_suffix(size_t rule, size_t start) const -> Set {
+        Set result;
+        for (size_t i = start; i < grammar.rule_size[rule]; i++) {
+            size_t symbol = grammar.rule_rhs[rule][i];
+            result.merge(first[symbol]);
+            if (!nullable.test(symbol)) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    constexpr auto suffix_nullable(size_t rule, size_t start) const -> bool {
+        for (size_t i = start; i < grammar.rule_size[rule]; i++) {
+            if (!nullable.test(grammar.rule_rhs[rule][i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+template <size_t MaxSymbols, size_t MaxRules, size_t MaxRhs>
+constexpr auto analyze(const StaticGrammar<MaxSymbols, MaxRules, MaxRhs> &g)
+    -> StaticTables<MaxSymbols, MaxRules, MaxRhs> {
+    StaticTables<MaxSymbols, MaxRules, MaxRhs> tables;
+    tables.grammar = g;
+
+    // Nullable (calc_nullable)
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t r = 0; r < g.num_rules; r++) {
+            if (!tables.nullable.test(g.rule_lhs[r]) &&
+                tables.suffix_nullable(r, 0)) {
+                changed |= tables.nullable.set(g.rule_lhs[r]);
+            }
+        }
+    }
+
+    // FIRST (calc_first)
+    for (size_t t = 0; t < g.num_terms; t++) {
+        tables.first[t].set(t);
+    }
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t r = 0; r < g.num_rules; r++) {
+            changed |= tables.first[g.rule_lhs[r]].merge(
+                tables.first_of_suffix(r, 0));
+        }
+    }
+
+    // FOLLOW (calc_follow): rules IV and V, then II and III to a fixed point
+    tables.follow[g.start()].set(tables.end_marker());
+    for (size_t r = 0; r < g.num_rules; r++) {
+        for (size_t i = 0; i < g.rule_size[r]; i++) {
+            size_t symbol = g.rule_rhs[r][i];
+            if (!g.is_term(symbol)) {
+                tables.follow[symbol].merge(tables.first_of_suffix(r, i + 1));
+            }
+        }
+    }
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t r = 0; r < g.num_rules; r++) {
+            for (size_t i = g.rule_size[r]; i-- > 0;) {
+                size_t symbol = g.rule_rhs[r][i];
+                if (g.is_term(symbol)) {
+                    break;
+                }
+                changed |=
+                    tables.follow[symbol].merge(tables.follow[g.rule_lhs[r]]);
+                if (!tables.nullable.test(symbol)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // LL(1) table (ll1::build_table)
+    for (auto &row : tables.ll1) {
+        for (int &cell : row) {
+            cell = -1;
+        }
+    }
+    SymbolSet<(MaxSymbols + 1) * MaxSymbols> clashed;
+    for (size_t r = 0; r < g.num_rules; r++) {
+        auto predict = tables.first_of_suffix(r, 0);
+        if (tables.suffix_nullable(r, 0)) {
+            predict.merge(tables.follow[g.rule_lhs[r]]);
+        }
+        size_t row = g.rule_lhs[r] - g.num_terms;
+        for (size_t lookahead = 0; lookahead <= g.num_terms; lookahead++) {
+            if (!predict.test(lookahead)) {
+                continue;
+            }
+            int &cell = tables.ll1[row][lookahead];
+            if (cell == -1) {
+                cell = static_cast<int>(r);
+            } else if (clashed.set(row * (MaxSymbols + 1) + lookahead)) {
+                tables.ll1_conflicts++;
+            }
+        }
+    }
+    return tables;
+}
+
+template <size_t MaxSymbols, size_t MaxRules, size_t MaxRhs>
+constexpr auto analyze(std::string_view text)
+    -> StaticTables<MaxSymbols, MaxRules, MaxRhs> {
+    return analyze(parse_grammar<MaxSymbols, MaxRules, MaxRhs>(text));
+}
+
+// Sizes the tables from the text itself, which must have static storage
+template <const char *Text> constexpr auto analyze() {
+    constexpr Capacity capacity = measure(Text);
+    return analyze<capacity.symbols, capacity.rules, capacity.rhs>(Text);
+}
+
+// Checks one line of a.out output for tasks 2-4, e.g.
+// "FIRST(E) = { LPAREN, NUM }", against the tables: the named set must hold
+// exactly the listed symbols. Lets static_assert compare against the
+// runtime engine's output verbatim.
+template <size_t MaxSymbols, size_t MaxRules, size_t MaxRhs>
+constexpr auto matches(const StaticTables<MaxSymbols, MaxRules, MaxRhs> &tables,
+                       std::string_view line) -> bool {
+    const auto &g = tables.grammar;
+    size_t open = line.find('{');
+    size_t close = line.rfind('}');
+    if (open == std::string_view::npos || close == std::string_view::npos ||
+        close < open) {
+        return false;
+    }
+
+    // The set being described
+    std::string_view head = line.substr(0, open);
+    SymbolSet<MaxSymbols + 1> expected_domain;
+    const SymbolSet<MaxSymbols + 1> *actual = nullptr;
+    if (head.substr(0, 8) == "Nullable") {
+        actual = &tables.nullable;
+        for (size_t s = g.num_terms; s < g.num_symbols; s++) {
+            expected_domain.set(s);
+        }
+    } else {
+        size_t paren = head.find('(');
+        size_t end = head.find(')');
+        if (paren == std::string_view::npos || end == std::string_view::npos) {
+            return false;
+        }
+        std::string_view kind = head.substr(0, paren);
+        size_t symbol = g.id(head.substr(paren + 1, end - paren - 1));
+        if (symbol == g.num_symbols) {
+            return false;
+        }
+        if (kind == "FIRST") {
+            actual = &tables.first[symbol];
+        } else if (kind == "FOLLOW") {
+            actual = &tables.follow[symbol];
+        } else {
+            return false;
+        }
+        for (size_t s = 0; s <= g.num_terms; s++) {
+            expected_domain.set(s);
+        }
+    }
+
+    // Listed members, separated by commas and spaces
+    SymbolSet<MaxSymbols + 1> expected;
+    std::string_view body = line.substr(open + 1, close - open - 1);
+    size_t i = 0;
+    while (i < body.size()) {
+        if (body[i] == ',' || detail::is_space(body[i])) {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < body.size() && body[i] != ',' &&
+               !detail::is_space(body[i])) {
+            i++;
+        }
+        std::string_view name = body.substr(start, i - start);
+        size_t symbol =
+            name == "$" ? tables.end_marker() : g.id(name);
+        if (symbol == g.num_symbols || !expected_domain.test(symbol)) {
+            return false;
+        }
+        expected.set(symbol);
+    }
+
+    for (size_t s = 0; s <= MaxSymbols; s++) {
+        if (expected_domain.test(s) && expected.test(s) != actual->test(s)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace compile_time
@@ -1,6 +1,24 @@
+#pragma once
 const int TASK_1 = 1;
 const int TASK_2 = 2;
 const int TASK_3 = 3;
 const int TASK_4 = 4;
 const int TASK_5 = 5;
 const int TASK_6 = 6;
+const int TASK_7 = 7;
+const int TASK_8 = 8;
+const int TASK_9 = 9;
+const int TASK_10 = 10;
+const int TASK_11 = 11;
+const int TASK_12 = 12;
+const int TASK_13 = 13;
+const int TASK_14 = 14;
+const int TASK_15 = 15;
+const int TASK_16 = 16;
+const int TASK_17 = 17;
+
+const int DEFAULT_LOOKAHEAD_K = 2;
+const int DEFAULT_SENTENCE_LENGTH = 6;
+const int DEFAULT_SENTENCE_COUNT = 1000;
+const int DEFAULT_SENTENCE_DEPTH = 64;
+const int DEFAULT_SEED = 1;
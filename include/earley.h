@@ -0,0 +1,69 @@
+#pragma once
+#include "symbols.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Grammar laid out for the Earley recognizer. Every rule owns the dotted
+// positions [rule_start[r], rule_start[r] + |rhs|]; an item is a position
+// plus an origin set.
+struct EarleyGrammar {
+    InternedGrammar grammar;
+    std::vector<int> rule_start;
+    std::vector<int> next_symbol; // symbol after the dot, -1 when complete
+    std::vector<int> lhs_of;      // lhs of the position's rule
+    std::vector<char> nullable;   // per symbol, from calc_nullable
+};
+
+// Scratch space for one recognizer thread; reused between sentences
+class EarleyRecognizer {
+  public:
+    explicit EarleyRecognizer(const EarleyGrammar &grammar);
+
+    // Tokens are terminal ids; anything else is rejected
+    auto recognize(const std::vector<int> &tokens) -> bool;
+
+  private:
+    const EarleyGrammar &grammar;
+
+    // Item sets back to back: set i is [set_start[i], set_start[i + 1])
+    std::vector<uint32_t> item_pos;
+    std::vector<uint32_t> item_origin;
+    std::vector<size_t> set_start;
+
+    // Open-addressing index of the set being built, cleared by stamping
+    std::vector<uint64_t> slot_key;
+    std::vector<uint32_t> slot_stamp;
+    uint32_t stamp = 0;
+    size_t slots_used = 0;
+
+    // Leo items memoised per (set, symbol): the topmost completed item of a
+    // deterministic right-recursive chain, or none
+    struct LeoEntry {
+        int symbol;
+        int64_t item; // pos << 32 | origin, -1 for no Leo item
+    };
+    std::vector<std::vector<LeoEntry>> leo;
+
+    auto begin_set() -> void;
+    auto add(uint32_t pos, uint32_t origin) -> void;
+    auto grow_index() -> void;
+    auto leo_item(uint32_t set, int symbol) -> int64_t;
+    auto find_leo(uint32_t set, int symbol) const -> const LeoEntry *;
+    auto unique_penultimate(uint32_t set, int symbol) const -> int64_t;
+};
+
+namespace earley {
+auto build_grammar(const Grammar &grammar) -> EarleyGrammar;
+
+// Task 14
+auto print_general_parse(const Grammar &grammar, const std::string &path,
+                         std::ostream &out = std::cout) -> void;
+// One result per sentence, recognised in parallel with util::parallel_for
+auto recognize_all(const EarleyGrammar &grammar,
+                   const std::vector<std::vector<int>> &sentences)
+    -> std::vector<char>;
+} // namespace earley
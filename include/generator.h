@@ -0,0 +1,53 @@
+#pragma once
+#include "symbols.h"
+#include "types.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Shortest derivations of every symbol and rule, computed to a fixed point
+// like calc_nullable. UNBOUNDED marks unproductive symbols and rules.
+struct DerivationBounds {
+    static const size_t UNBOUNDED = static_cast<size_t>(-1);
+
+    std::vector<size_t> symbol_length; // fewest terminals derivable
+    std::vector<size_t> symbol_height; // lowest derivation tree (terms are 0)
+    std::vector<size_t> rule_length;
+    std::vector<size_t> rule_height;
+};
+
+// Fewest terminals derivable by a tree at most h high, row h per symbol.
+// Short sentences may need tall trees and short trees long sentences, so
+// DerivationBounds alone can't tell whether both limits can be met at once.
+// Rows stop once they stop changing; taller heights use the last one.
+struct HeightBoundedLengths {
+    std::vector<std::vector<size_t>> rows;
+
+    auto at(int symbol, size_t height) const -> size_t {
+        return rows[std::min(height, rows.size() - 1)][symbol];
+    }
+};
+
+struct GeneratorOptions {
+    size_t max_length = 0; // terminals per sentence, raised to the minimum
+    size_t max_depth = 0;  // derivation tree height, raised to the minimum
+    size_t count = 0;
+    uint64_t seed = 0;
+};
+
+namespace generator {
+auto calc_derivation_bounds(const InternedGrammar &grammar)
+    -> DerivationBounds;
+auto calc_height_bounded_lengths(const InternedGrammar &grammar,
+                                 size_t max_height) -> HeightBoundedLengths;
+
+// Task 15. Sentences are produced in blocks, each with its own RNG stream
+// seeded from (seed, block), so the output for a seed does not depend on
+// the thread count. Blocks are generated in parallel and written in order.
+auto print_random_sentences(const Grammar &grammar,
+                            const GeneratorOptions &options,
+                            std::ostream &out = std::cout) -> void;
+} // namespace generator
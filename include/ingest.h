@@ -0,0 +1,25 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+
+namespace ingest {
+const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+/*
+ * Parses grammar text on worker threads. The text is split into chunks
+ * right after '*' characters, which always end a rule, and only before the
+ * first '#'. Each chunk gets its own Parser; the per-chunk symbol orders
+ * are then merged in chunk order, so universe_order (and everything
+ * ordered by it) is exactly what one sequential parse gives. On malformed
+ * input, the SyntaxError of the earliest failing chunk is rethrown with its
+ * line counted from the start of the text, as a sequential parse reports
+ * it. EBNF input is parsed sequentially, since its helpers are named from
+ * the whole grammar.
+ */
+auto parse_chunked(const char *begin, const char *end,
+                   size_t min_chunk_bytes = MIN_CHUNK_BYTES) -> Grammar;
+
+// Maps standard input when it is a regular file, or reads it all
+// otherwise, then parses it with parse_chunked
+auto parse_stdin(size_t min_chunk_bytes = MIN_CHUNK_BYTES) -> Grammar;
+} // namespace ingest
@@ -0,0 +1,45 @@
+#pragma once
+#include "bitset.h"
+#include "symbols.h"
+#include "types.h"
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// LR(0) automaton with LALR(1) lookaheads. The grammar is augmented with
+// S' -> S as rule `augmented_rule`; S' has symbol id num_symbols() and the
+// end marker $ is the extra terminal num_terms in every lookahead set.
+struct LalrAutomaton {
+    InternedGrammar grammar;
+    int augmented_rule = 0;
+
+    // Items are numbered rule by rule: item_base[r] + dot
+    std::vector<int> item_base;
+    std::vector<int> item_rule;
+
+    // Per state: sorted kernel items, transitions sorted by symbol, and the
+    // completed rules with their lookaheads
+    std::vector<std::vector<int>> kernels;
+    std::vector<std::vector<std::pair<int, int>>> transitions;
+    std::vector<std::vector<int>> reductions;
+    std::vector<std::vector<Bitset>> lookaheads;
+
+    auto end_marker() const -> int { return grammar.num_terms; }
+    auto goto_state(int state, int symbol) const -> int;
+};
+
+struct LalrConflict {
+    int state;
+    int terminal; // end_marker() for $
+    bool shift;
+    std::vector<int> rules;
+};
+
+namespace analysis {
+// Task 9
+auto print_lalr_report(const Grammar &grammar, std::ostream &out = std::cout)
+    -> void;
+auto build_lalr(const Grammar &grammar) -> LalrAutomaton;
+auto find_lalr_conflicts(const LalrAutomaton &automaton)
+    -> std::vector<LalrConflict>;
+} // namespace analysis
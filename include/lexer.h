@@ -6,6 +6,7 @@
 #ifndef __LEXER__H__
 #define __LEXER__H__
 
+#include <iostream>
 #include <vector>
 #include <string>
 
@@ -13,7 +14,9 @@
 
 // Lexer modified for FIRST & FOLLOW project
 
-typedef enum { END_OF_FILE = 0, ARROW, STAR, HASH, ID, ERROR, OR } TokenType;
+// LPAREN through PLUS are the EBNF operators ( ) [ ] { } +
+typedef enum { END_OF_FILE = 0, ARROW, STAR, HASH, ID, ERROR, OR,
+               LPAREN, RPAREN, LBRAC, RBRAC, LBRACE, RBRACE, PLUS } TokenType;
 
 class Token {
   public:
@@ -26,9 +29,12 @@ class Token {
 
 class LexicalAnalyzer {
   public:
-    Token GetToken();
-    Token peek(int);
+    // Both refer into the token list, which is filled by the constructor and
+    // never changes afterwards
+    const Token &GetToken();
+    const Token &peek(int);
     LexicalAnalyzer();
+    explicit LexicalAnalyzer(std::istream& in);
 
   private:
     std::vector<Token> tokenList;
@@ -36,6 +42,7 @@ class LexicalAnalyzer {
     int line_no;
     int index;
     Token tmp;
+    Token end_of_file;
     InputBuffer input;
 
     bool SkipSpace();
@@ -0,0 +1,55 @@
+#pragma once
+#include "symbols.h"
+#include "types.h"
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Table cell claimed by more than one rule
+struct LL1Conflict {
+    int non_term;
+    int lookahead;
+    std::vector<int> rules;
+};
+
+// Predictive parse table built from FIRST/FOLLOW. Lookahead num_terms is $.
+struct LL1Table {
+    InternedGrammar grammar;
+    std::vector<int> entries; // rule per (nt, lookahead), -1 for an error
+    std::vector<LL1Conflict> conflicts;
+
+    auto width() const -> int { return grammar.num_terms + 1; }
+    auto entry(int nt, int lookahead) const -> int {
+        return entries[(nt - grammar.num_terms) * width() + lookahead];
+    }
+};
+
+namespace ll1 {
+auto build_table(const Grammar &grammar) -> LL1Table;
+
+// Tokens are terminal ids; anything else (e.g. -1 for an unknown name) is
+// rejected. stack is scratch space reused between calls.
+auto parse(const LL1Table &table, const std::vector<int> &tokens,
+           std::vector<int> &stack) -> bool;
+
+// Sentences are one per line, terminal names separated by spaces
+auto read_sentences(std::istream &in, const InternedGrammar &grammar)
+    -> std::vector<std::vector<int>>;
+
+// Task 11
+auto print_generated_parser(const Grammar &grammar,
+                            std::ostream &out = std::cout) -> void;
+auto generate_parser(const LL1Table &table, std::ostream &out) -> void;
+
+// Task 12
+auto print_table_parse(const Grammar &grammar, const std::string &path,
+                       std::ostream &out = std::cout) -> void;
+
+// Task 13
+auto print_enumerated_sentences(const Grammar &grammar, size_t max_length,
+                                size_t count, std::ostream &out = std::cout)
+    -> void;
+auto enumerate_sentences(const InternedGrammar &grammar, size_t max_length,
+                         size_t count) -> std::vector<std::vector<int>>;
+} // namespace ll1
@@ -0,0 +1,66 @@
+#pragma once
+#include "symbols.h"
+#include "types.h"
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Terminal strings of length <= k stored as nodes of a shared-prefix trie.
+// A tuple's id is the id of the trie node that spells it, so two sets holding
+// the same tuple share its storage and tuples compare by a single int.
+class TupleTrie {
+  public:
+    static const int EPSILON = 0;
+
+    TupleTrie(int k, int end_marker);
+
+    auto child(int node, int symbol) -> int;
+    auto concat(int prefix, int suffix) -> int;
+    auto symbols(int node) const -> std::vector<int>;
+    auto depth(int node) const -> int { return depths[node]; }
+    auto last(int node) const -> int { return last_symbols[node]; }
+    auto is_complete(int node) const -> bool;
+    auto size() const -> size_t { return parents.size(); }
+
+  private:
+    int k;
+    int end_marker;
+    std::vector<int> parents;
+    std::vector<int> last_symbols;
+    std::vector<int> depths;
+    std::unordered_map<uint64_t, int> children;
+};
+
+using TupleSet = std::unordered_set<int>;
+
+// FIRST_k / FOLLOW_k over an interned grammar. Sets are indexed by
+// (nt - num_terms); the end marker $ is interned as symbol id num_symbols().
+struct LookaheadSets {
+    InternedGrammar grammar;
+    TupleTrie trie;
+    std::vector<TupleSet> first;
+    std::vector<TupleSet> follow;
+
+    LookaheadSets(InternedGrammar interned, int k)
+        : grammar(std::move(interned)), trie(k, grammar.num_symbols()) {}
+};
+
+namespace analysis {
+// Task 7
+auto print_first_k_sets(const Grammar &grammar, int k,
+                        std::ostream &out = std::cout) -> void;
+auto calc_first_k(const Grammar &grammar, int k) -> LookaheadSets;
+
+// Task 8
+auto print_follow_k_sets(const Grammar &grammar, int k,
+                         std::ostream &out = std::cout) -> void;
+auto calc_follow_k(const Grammar &grammar, int k) -> LookaheadSets;
+
+auto concat_k(TupleTrie &trie, const TupleSet &prefixes,
+              const TupleSet &suffixes) -> TupleSet;
+auto first_k_of_subset(LookaheadSets &sets, const std::vector<int> &symbols,
+                       size_t start_idx) -> TupleSet;
+} // namespace analysis
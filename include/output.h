@@ -0,0 +1,48 @@
+#pragma once
+#include "analysis.h"
+#include "types.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// How tasks 1-6 and 10 print their results. TEXT is the classic output.
+enum class OutputFormat { TEXT, NDJSON, BINARY };
+
+// NDJSON: one object per line,
+//   {"kind":"terminal","name":"a"}              (Task 1, in order)
+//   {"set":"Nullable","members":["A"]}           (Task 2)
+//   {"set":"FIRST","symbol":"A","members":["a"]} (Tasks 3, 4)
+//   {"lhs":"A","rhs":["x","y"]}                  (Tasks 5, 6, 10)
+//   {"stage":"first"}                            (--pipeline sections)
+// Names come from the lexer (alphanumeric, or $), so nothing is escaped.
+//
+// BINARY: the same records, each a little-endian u32 payload length then
+// the payload: a u8 record type (1 symbol, 2 set, 3 rule, 4 stage) and its
+// fields.
+// Strings are a u32 length and bytes, lists a u32 count and items.
+//   symbol: u8 kind (0 terminal, 1 nonterminal), name
+//   set:    set name, symbol ("" for Nullable), member list
+//   rule:   lhs, rhs list
+//   stage:  stage name
+//
+// Records appear in the same order as the text output and are written
+// straight to the stream, without building strings first.
+namespace output {
+auto parse_format(const std::string &name, OutputFormat &format) -> bool;
+
+auto write_symbols(const Grammar &grammar, OutputFormat format,
+                   std::ostream &out) -> void;
+auto write_nullable(const Grammar &grammar, OutputFormat format,
+                    std::ostream &out) -> void;
+auto write_set_map(const SetMap &map, const Grammar &grammar,
+                   const std::string &set_name, OutputFormat format,
+                   std::ostream &out) -> void;
+auto write_rules(std::vector<Rule> &rules, OutputFormat format,
+                 std::ostream &out) -> void;
+auto write_stage(const std::string &name, OutputFormat format,
+                 std::ostream &out) -> void;
+
+// Sorts rules as print_rules does (by their "A -> x y #" text) without
+// building that text
+auto sort_rules_as_text(std::vector<Rule> &rules) -> void;
+} // namespace output
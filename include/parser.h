@@ -1,13 +1,41 @@
 #include "lexer.h"
 #include "types.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
+
+// Thrown on malformed grammar input; callers decide whether to exit. line is
+// where the offending token is, counting from 1.
+struct SyntaxError : std::runtime_error {
+    explicit SyntaxError(int line = 0)
+        : std::runtime_error("SYNTAX ERROR !!!!!!!!!!!!!!"), line(line) {}
+    int line;
+};
+
+// What parsing one chunk of the input found: its rules, the symbols in the
+// order they first appear, and the lhs symbols
+struct ParsedChunk {
+    std::vector<Rule> rules;
+    std::vector<std::string> universe_order;
+    std::unordered_set<std::string> non_terms;
+};
+
 class Parser {
   public:
     Parser();
+    explicit Parser(std::istream &in);
     void parse_input();
     auto generate_grammar() -> Grammar;
 
+    // Parses input that starts and ends at rule boundaries. Only the first
+    // chunk must hold a rule and only the last ends with HASH.
+    void parse_chunk(bool first, bool last);
+    auto uses_ebnf() const -> bool { return !helpers.empty(); }
+    auto take_chunk() -> ParsedChunk;
+
   private:
     LexicalAnalyzer lexer;
     std::vector<Rule> rules;
@@ -18,14 +46,36 @@ class Parser {
     std::vector<std::string> non_term_order;
     std::vector<std::string> term_order;
 
+    // EBNF desugaring. Helper nonterminals are hash-consed on their shape
+    // and alternatives, referenced by placeholder while parsing, and named once
+    // the whole universe is known so they can't clash with grammar symbols.
+    struct Helper {
+        std::string base; // lhs of the rule that first needed it
+        std::string name; // "Group", "Opt" or "Rep"
+    };
+    std::vector<Helper> helpers;
+    std::vector<Rule> helper_rules;
+    std::vector<std::string> helper_names;
+    std::unordered_map<std::string, std::string> helper_by_key;
+    std::string current_lhs;
+
     void parse_grammar();
     void parse_rule_list();
     auto parse_rule() -> std::vector<Rule>;
     auto parse_rhs() -> std::vector<IDList>;
     auto parse_id_list() -> IDList;
+    auto parse_item() -> IDList;
+    auto parse_primary() -> IDList;
+
+    auto group(std::vector<IDList> alternatives,
+               const std::string &name = "Group") -> IDList;
+    auto repetition(std::vector<IDList> alternatives) -> IDList;
+    auto helper(bool recursive, const std::string &name,
+                std::vector<IDList> alternatives) -> std::string;
+    void name_helpers();
 
     void update_universe(const Token &tok);
 
-    static void syntax_error();
-    auto expect(TokenType expected_type) -> Token;
+    static void syntax_error(int line);
+    auto expect(TokenType expected_type) -> const Token &;
 };
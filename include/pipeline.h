@@ -0,0 +1,43 @@
+#pragma once
+#include "tasks.h"
+#include "types.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// One step of --pipeline. Transforms hand their grammar to the next stage in
+// memory; analyses print their sets and leave the grammar as it is.
+enum class PipelineStage {
+    REDUCE,    // Task 10
+    UNLEFTREC, // Task 6
+    FACTOR,    // Task 5
+    MERGE,     // Task 16
+    SYMBOLS,   // Task 1
+    NULLABLE,  // Task 2
+    FIRST,     // Task 3
+    FOLLOW,    // Task 4
+};
+
+namespace pipeline {
+// Parses "reduce,unleftrec,factor,first,follow". On failure, bad is the
+// stage name that was not recognized.
+auto parse_stages(const std::string &spec, std::vector<PipelineStage> &stages,
+                  std::string &bad) -> bool;
+
+/*
+ * Runs the stages in order on one in-memory grammar. A transform's rules
+ * are rebuilt into a Grammar as re-parsing its printed output would if the
+ * rules were listed by lhs in the old nonterminal order, new nonterminals
+ * last: the start symbol stays first and each new nonterminal follows the
+ * one whose rules first use it.
+ * Analyses always print; a transform prints when it is the last stage or
+ * dump is set. With more than one section, each is preceded by a
+ * "== stage ==" header (a stage record in ndjson and binary output).
+ * Returns false, after an error line, if a transform leaves no rules for
+ * the stages after it.
+ */
+auto run_pipeline(Grammar grammar,
+                  const std::vector<PipelineStage> &stages, bool dump,
+                  const TaskOptions &options, std::ostream &out = std::cout)
+    -> bool;
+} // namespace pipeline
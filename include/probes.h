@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+ * Static tracepoints (USDT) for profiling a release build with perf or
+ * bpftrace, e.g. a histogram of parse latencies:
+ *
+ *   bpftrace -e 'usdt:./a.out:project2:parse_start { @t[tid] = nsecs; }
+ *                usdt:./a.out:project2:parse_done {
+ *                    @ns = hist(nsecs - @t[tid]); }'
+ *   perf buildid-cache --add ./a.out && perf record -e sdt_project2:first_pass
+ *
+ * With <sys/sdt.h> (systemtap-sdt-dev on Debian/Ubuntu, systemtap-sdt-devel
+ * on Fedora/RHEL), each probe is one nop plus an ELF note naming its
+ * arguments; nothing runs until a tracer attaches. Without the header, or
+ * with PROJECT2_NO_PROBES defined, the probes compile away and their
+ * arguments are never evaluated. Where probes exist, arguments
+ * are evaluated, so they are kept to sizes and counters already at hand.
+ *
+ * Probes, provider project2:
+ *   lex_done(tokens, lines)
+ *   parse_start()
+ *   parse_done(rules, symbols)
+ *   nullable_pass(pass, added, size)       after every pass
+ *   first_pass(pass, added, size)          size: elements in all sets
+ *   follow_init(size)
+ *   follow_pass(pass, added, size)
+ *   factor_start(index, name)              name: char *, per nonterminal
+ *   factor_done(index, name, rules)        rules: rules it was factored into
+ *   unleftrec_start(index, name, rules)
+ *   unleftrec_done(index, name, rules)     rules: its own and its new A1's
+ *   ingest_done(chunks, rules)             after --ingest=parallel
+ */
+
+#if !defined(PROJECT2_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PROJECT2_HAVE_PROBES 1
+#endif
+#endif
+
+#ifdef PROJECT2_HAVE_PROBES
+#define PROBE0(name) DTRACE_PROBE(project2, name)
+#define PROBE1(name, a) DTRACE_PROBE1(project2, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(project2, name, a, b)
+#define PROBE3(name, a, b, c) DTRACE_PROBE3(project2, name, a, b, c)
+#else
+// sizeof keeps the arguments used without evaluating them
+#define PROBE0(name) ((void)0)
+#define PROBE1(name, a) ((void)sizeof(a))
+#define PROBE2(name, a, b) ((void)sizeof(a), (void)sizeof(b))
+#define PROBE3(name, a, b, c)                                                  \
+    ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c))
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+#include "symbols.h"
+#include "types.h"
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Minimal DFA over terminal ids. Terminals that no state tells apart share
+ * a column, so the table is dense but only as wide as it needs to be:
+ * state s, terminal t goes to next[s * width + column[t]]. Column 0 is the
+ * terminals the DFA never reads. Every state can still reach an accepting
+ * one, so DEAD means reject; a DFA for an empty language has no states and
+ * starts DEAD.
+ */
+struct Dfa {
+    static const int DEAD = -1;
+
+    int start = DEAD;
+    int width = 1;
+    std::vector<int> column; // per terminal id
+    std::vector<int> next;
+    std::vector<char> accepting;
+
+    auto num_states() const -> int {
+        return static_cast<int>(accepting.size());
+    }
+    auto step(int state, int term) const -> int {
+        return next[state * width + column[term]];
+    }
+
+    // Tokens outside the grammar's terminals (read_sentences gives -1) reject
+    auto accepts(const std::vector<int> &tokens) const -> bool {
+        const int num_terms = static_cast<int>(column.size());
+        int state = start;
+        for (int token : tokens) {
+            if (state == DEAD || token < 0 || token >= num_terms) {
+                return false;
+            }
+            state = next[state * width + column[token]];
+        }
+        return state != DEAD && accepting[state] != 0;
+    }
+};
+
+// Regular nonterminals of a grammar, each compiled into its own DFA
+struct RegularGrammar {
+    InternedGrammar grammar;
+    // Per nonterminal (nt - num_terms): index into dfas, or -1
+    std::vector<int> dfa_of;
+    std::vector<Dfa> dfas;
+    // Regular components, callees before callers; ids are nonterminal ids
+    std::vector<std::vector<int>> components;
+
+    auto dfa(int nt) const -> const Dfa * {
+        int index = dfa_of[nt - grammar.num_terms];
+        return index < 0 ? nullptr : &dfas[index];
+    }
+};
+
+namespace regular {
+// Components whose NFA, or any of whose DFAs before minimization, would
+// need more states are left to the general parsers
+const size_t MAX_STATES = 1 << 16;
+// Callers inline copies of their callees, so a long chain of regular
+// nonterminals costs quadratic space. Compiling stops before the tables of
+// all DFAs (next plus column entries) would pass this many entries.
+const size_t MAX_TABLE = 1 << 24;
+
+/*
+ * Finds the strongly connected sets of nonterminals that form regular
+ * sub-grammars and compiles each member into a minimal DFA. Components are
+ * visited callees first; one is regular when every rule of every member
+ * reads terminals and already compiled nonterminals, and may end with one
+ * nonterminal of the component itself (right-linear, as in
+ * idList1 -> COMMA ID idList1 | epsilon). Compiled callees are inlined as
+ * copies of their DFAs, so decl -> idList colon ID is regular too. The
+ * component's NFA goes through subset construction, then states that can't
+ * accept are trimmed and the rest minimized by partition refinement.
+ */
+auto compile(const Grammar &grammar) -> RegularGrammar;
+
+// Task 17: every DFA, or with a sentences file, the start symbol's DFA run
+// on each sentence
+auto print_regular_report(const Grammar &grammar,
+                          std::ostream &out = std::cout) -> void;
+auto print_regular_parse(const Grammar &grammar, const std::string &path,
+                         std::ostream &out = std::cout) -> void;
+} // namespace regular
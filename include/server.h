@@ -0,0 +1,44 @@
+#pragma once
+#include "budget.h"
+#include <cstddef>
+#include <string>
+
+namespace server {
+
+const size_t DEFAULT_CACHE_CAPACITY = 64;
+// STATS percentiles cover this many of the most recent requests
+const size_t LATENCY_WINDOW = 10000;
+
+/*
+ * Long-running query server. One request per line, one response per
+ * request:
+ *
+ *   TASK <n> <path>     output of `a.out n < path`
+ *   ADD <path> <rules>  append rules (grammar syntax, ending in *)
+ *   REMOVE <path> <rules>
+ *   STATS               request count, cache hits and latency percentiles
+ *                       of the last LATENCY_WINDOW requests
+ *   SHUTDOWN
+ *
+ * Responses are "OK <bytes>\n" followed by that many bytes of payload, or
+ * "ERR <message>\n". Parsed grammars and task outputs are kept in an LRU
+ * cache keyed by path and content hash, so editing a file starts over from
+ * its new content. Each TASK runs under the budget; one that exceeds it gets
+ * an ERR response and the server keeps going, as does one whose task fails
+ * (the first line of its "Error: ..." output).
+ */
+auto serve_socket(const std::string &socket_path, size_t cache_capacity,
+                  const Budget &budget) -> int;
+auto serve_stdio(size_t cache_capacity, const Budget &budget) -> int;
+
+// Concurrent clients sending TASK requests; prints latency percentiles
+struct LoadOptions {
+    std::string socket_path;
+    std::string grammar_path;
+    int task = 3;
+    int clients = 4;
+    int requests = 1000;
+};
+auto run_load_generator(const LoadOptions &options) -> int;
+
+} // namespace server
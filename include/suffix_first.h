@@ -0,0 +1,55 @@
+#pragma once
+#include "analysis.h"
+#include "symbols.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// FIRST and nullability of one rhs suffix. The FIRST set is the slice
+// [begin, end) of SuffixFirstTable::terms, terminal ids ascending.
+struct SuffixFirst {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    bool nullable = true;
+
+    auto size() const -> size_t { return end - begin; }
+};
+
+// FIRST/nullable of every rhs suffix (rule, position), built once per
+// grammar. Suffixes are nodes of a trie grown right-to-left, so identical
+// suffixes of different rules are one node, and a node reuses the FIRST
+// slice of its first symbol or of its tail whenever the union adds nothing.
+// Symbol ids are those of InternedGrammar.
+struct SuffixFirstTable {
+    std::vector<int> terms;
+    std::vector<SuffixFirst> nodes; // nodes[0] is the empty suffix
+
+    // Node of rule r's suffix from position p is positions[rule_start[r] + p];
+    // p runs up to rhs.size(), the empty suffix
+    std::vector<size_t> rule_start;
+    std::vector<int> positions;
+
+    // Node of the one-symbol sequence of every symbol
+    std::vector<int> symbol_nodes;
+
+    auto at(size_t rule, size_t pos) const -> const SuffixFirst & {
+        return nodes[positions[rule_start[rule] + pos]];
+    }
+    auto of_symbol(int symbol) const -> const SuffixFirst & {
+        return nodes[symbol_nodes[symbol]];
+    }
+    auto first_begin(const SuffixFirst &suffix) const -> const int * {
+        return terms.data() + suffix.begin;
+    }
+    auto first_end(const SuffixFirst &suffix) const -> const int * {
+        return terms.data() + suffix.end;
+    }
+};
+
+namespace analysis {
+auto build_suffix_first(const InternedGrammar &grammar, const SetMap &first,
+                        const std::unordered_set<std::string> &nullable)
+    -> SuffixFirstTable;
+} // namespace analysis
@@ -0,0 +1,38 @@
+#pragma once
+#include "types.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Grammar with every symbol replaced by a dense integer id. Terminals take
+// ids [0, num_terms) in term_order, nonterminals follow in non_term_order, so
+// comparing ids compares first-appearance rank within each group.
+struct InternedGrammar {
+    std::vector<std::string> names;
+    std::unordered_map<std::string, int> ids;
+    int num_terms = 0;
+
+    // Rules keep the order of Grammar::rules
+    std::vector<int> rule_lhs;
+    std::vector<std::vector<int>> rule_rhs;
+
+    // Rule indices per nonterminal, indexed by (nt - num_terms)
+    std::vector<std::vector<int>> rules_of;
+
+    auto is_term(int symbol) const -> bool { return symbol < num_terms; }
+    auto num_symbols() const -> int { return static_cast<int>(names.size()); }
+    auto num_non_terms() const -> int { return num_symbols() - num_terms; }
+    auto start() const -> int { return num_terms; }
+};
+
+namespace analysis {
+auto intern_grammar(const Grammar &grammar) -> InternedGrammar;
+} // namespace analysis
+
+namespace graph {
+// Tarjan's algorithm, iterative so deep grammars can't overflow the stack.
+// Components are returned in reverse topological order: every component is
+// emitted after all components reachable from it.
+auto strongly_connected_components(const std::vector<std::vector<int>> &edges)
+    -> std::vector<std::vector<int>>;
+} // namespace graph
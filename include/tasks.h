@@ -0,0 +1,32 @@
+#pragma once
+#include "consts.h"
+#include "output.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Settings that change what a task prints
+struct TaskOptions {
+    int k = DEFAULT_LOOKAHEAD_K;
+    std::string sentences_path;
+    size_t max_length = DEFAULT_SENTENCE_LENGTH;
+    size_t count = DEFAULT_SENTENCE_COUNT;
+    size_t max_depth = DEFAULT_SENTENCE_DEPTH;
+    uint64_t seed = DEFAULT_SEED;
+    OutputFormat format = OutputFormat::TEXT;
+    bool merge = false; // merge equivalent nonterminals after Tasks 5 and 6
+    bool merge_compare = false;
+    // Task 5 factors only prefixes of alternatives whose FIRST sets clash
+    bool factor_conflicts = false;
+};
+
+namespace tasks {
+// Whether the task prints ndjson and binary as well as text
+auto supports_format(int task) -> bool;
+
+// Runs one task on a parsed grammar. Returns false for an unknown task.
+auto run_task(int task, const Grammar &grammar, const TaskOptions &options,
+              std::ostream &out = std::cout) -> bool;
+} // namespace tasks
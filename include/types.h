@@ -3,6 +3,7 @@
 #include "util.h"
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 using IDList = std::vector<std::string>;
@@ -16,13 +17,28 @@ struct Rule {
         return lhs == other.lhs && rhs == other.rhs;
     }
 
-    Rule(const std::string &non_term, const IDList &symbols) {
-        lhs = non_term;
-        rhs = symbols;
-    }
+    // Pass temporaries (or std::move) to build a rule without copying
+    Rule(std::string non_term, IDList symbols)
+        : lhs(std::move(non_term)), rhs(std::move(symbols)) {}
 
     auto to_string() const -> std::string {
-        return lhs + " -> " + util::join_vec_string(rhs, " ") + " #";
+        // lhs + " -> " + the rhs joined by spaces + " #", sized up front
+        size_t length = lhs.size() + 6;
+        for (const std::string &symbol : rhs) {
+            length += symbol.size() + 1;
+        }
+        std::string text;
+        text.reserve(length);
+        text += lhs;
+        text += " -> ";
+        for (size_t i = 0; i < rhs.size(); i++) {
+            if (i > 0) {
+                text += ' ';
+            }
+            text += rhs[i];
+        }
+        text += " #";
+        return text;
     }
 
     auto starts_with(const std::string &first_symbol) const -> bool {
@@ -1,11 +1,22 @@
 #pragma once
+#include "budget.h"
 #include "lexer.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace parser_util {
 auto starts_rule(const Token &tok) -> bool;
 auto is_follow_id_list(const Token &tok) -> bool;
+auto starts_item(const Token &tok) -> bool;
 
 } // namespace parser_util
 
@@ -14,9 +25,16 @@ namespace util {
 auto join_vec_string(const std::vector<std::string> &vec,
                      const std::string &delimiter) -> std::string;
 
+// Position of every name in an order vector, built once per output
+using RankIndex = std::unordered_map<std::string, size_t>;
+auto rank_index(const std::vector<std::string> &order) -> RankIndex;
+
 auto generate_ordered_vec(const std::unordered_set<std::string> &set,
                           const std::vector<std::string> &order)
     -> std::vector<std::string>;
+auto generate_ordered_vec(const std::unordered_set<std::string> &set,
+                          const RankIndex &rank)
+    -> std::vector<const std::string *>;
 
 auto print_unordered_set(const std::unordered_set<std::string> &set) -> void;
 
@@ -25,10 +43,81 @@ auto merge_vectors(std::vector<T> &vec1, const std::vector<T> &vec2) -> void {
     vec1.insert(vec1.end(), vec2.begin(), vec2.end());
 }
 
+// Moves the elements of vec2 instead, taking its buffer if vec1 is empty
+template <typename T>
+auto merge_vectors(std::vector<T> &vec1, std::vector<T> &&vec2) -> void {
+    if (vec1.empty()) {
+        vec1 = std::move(vec2);
+        return;
+    }
+    vec1.insert(vec1.end(), std::make_move_iterator(vec2.begin()),
+                std::make_move_iterator(vec2.end()));
+}
+
+// Number of threads used by parallel_for; 0 means one per hardware thread
+auto set_worker_threads(size_t threads) -> void;
+auto worker_threads() -> size_t;
+
+// Runs fn(i) for every i in [0, count) on a pool of worker threads. Workers
+// pull the next index from a shared counter, so fn can write slot i of a
+// pre-sized output without locking. Workers count against the caller's
+// budget; the first exception stops the remaining indices and is rethrown
+// on the calling thread.
+template <typename Fn> auto parallel_for(size_t count, Fn fn) -> void {
+    size_t threads = std::min(worker_threads(), count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    budget::RunState *run = budget::current();
+    auto worker = [&]() {
+        budget::Join join(run);
+        try {
+            for (size_t i = next++; i < count; i = next++) {
+                fn(i);
+            }
+        } catch (...) {
+            next = count;
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Looks the value up before inserting, so a value already in the set is
+// never copied into a node that is then thrown away
+template <typename T>
+auto insert_missing(std::unordered_set<T> &set, const T &value) -> void {
+    if (set.find(value) == set.end()) {
+        set.insert(value);
+    }
+}
+
 template <typename T>
 auto merge_sets(std::unordered_set<T> &set1, const std::unordered_set<T> &set2)
     -> void {
-    set1.insert(set2.begin(), set2.end());
+    for (const T &value : set2) {
+        insert_missing(set1, value);
+    }
 }
 
 } // namespace util
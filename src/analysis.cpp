@@ -1,7 +1,15 @@
 #include "analysis.h"
+#include "budget.h"
+#include "output.h"
+#include "probes.h"
+#include "suffix_first.h"
+#include "symbols.h"
 #include "types.h"
 #include "util.h"
 #include <algorithm>
+#include <cctype>
+#include <initializer_list>
+#include <iterator>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -9,14 +17,188 @@
 #include <unordered_map>
 #include <unordered_set>
 
+namespace {
+
+// What a rule costs the memory budget
+auto rule_bytes(const Rule &rule) -> size_t {
+    return sizeof(Rule) + rule.rhs.size() * sizeof(std::string);
+}
+
+template <typename Rules> auto rules_bytes(const Rules &rules) -> size_t {
+    size_t bytes = 0;
+    for (const Rule &rule : rules) {
+        bytes += rule_bytes(rule);
+    }
+    return bytes;
+}
+
+// Factoring out a prefix creates A -> prefix A1 and A1 -> postfix for each
+// postfix
+auto charge_factoring(const std::vector<std::vector<std::string>> &postfixes,
+                      size_t prefix_size, size_t round) -> void {
+    size_t bytes = sizeof(Rule) + (prefix_size + 1) * sizeof(std::string);
+    for (const auto &postfix : postfixes) {
+        bytes += sizeof(Rule) + postfix.size() * sizeof(std::string);
+    }
+    budget::charge(postfixes.size() + 1, bytes, "left factoring round", round,
+                   0);
+}
+
+// Moves every rule out of a set that is dropped right after. The elements
+// are const only to protect their hashes, and the set is cleared before
+// anything could hash them again.
+auto move_rules(unordered_set<Rule, RuleHasher> &rules, vector<Rule> &out)
+    -> void {
+    out.reserve(out.size() + rules.size());
+    for (const Rule &rule : rules) {
+        out.push_back(std::move(const_cast<Rule &>(rule)));
+    }
+    rules.clear();
+}
+
+// Compares a[0] + a[1] + ... with b[0] + b[1] + ... without building
+// either string
+auto joined_less(const std::string *a, size_t a_size, const std::string *b,
+                 size_t b_size) -> bool {
+    size_t i = 0;
+    size_t j = 0;
+    size_t a_offset = 0;
+    size_t b_offset = 0;
+    while (true) {
+        while (i < a_size && a_offset == a[i].size()) {
+            i++;
+            a_offset = 0;
+        }
+        while (j < b_size && b_offset == b[j].size()) {
+            j++;
+            b_offset = 0;
+        }
+        if (i == a_size || j == b_size) {
+            return i == a_size && j != b_size;
+        }
+        char a_char = a[i][a_offset++];
+        char b_char = b[j][b_offset++];
+        if (a_char != b_char) {
+            return static_cast<unsigned char>(a_char) <
+                   static_cast<unsigned char>(b_char);
+        }
+    }
+}
+
+// Longest prefix shared by two rules for which shares(rule1, rule2) holds;
+// ties go to the lowest joined names
+template <typename Shares>
+auto longest_prefix_where(const unordered_set<Rule, RuleHasher> &rules,
+                          Shares shares) -> vector<string> {
+    // The best prefix so far is a prefix of best->rhs; candidates are only
+    // copied out once they win
+    const Rule *best = nullptr;
+    size_t best_size = 0;
+    size_t compared = 0;
+    for (const Rule &rule1 : rules) {
+        // Quadratic in the rule count, so huge rule sets check in here too
+        budget::check("shared prefix search rule", ++compared, rules.size());
+        for (const Rule &rule2 : rules) {
+            if (rule1 == rule2) {
+                continue;
+            }
+
+            size_t size = 0;
+            size_t limit = std::min(rule1.rhs.size(), rule2.rhs.size());
+            while (size < limit && rule1.rhs[size] == rule2.rhs[size]) {
+                size++;
+            }
+
+            // This prefix must be either larger than curr_largest or equal in
+            // size but lower in lexicographic value (of the joined names)
+            if ((size > best_size ||
+                 (size == best_size && best != nullptr &&
+                  joined_less(rule2.rhs.data(), size, best->rhs.data(),
+                              best_size))) &&
+                shares(rule1, rule2)) {
+                best = &rule2;
+                best_size = size;
+            }
+        }
+    }
+    if (best == nullptr) {
+        return {};
+    }
+    return vector<string>(best->rhs.begin(), best->rhs.begin() + best_size);
+}
+
+// FIRST of symbols, plus "" when all of them are nullable. Nonterminals
+// made up by factoring are looked up in made, whose sets carry the "".
+auto predict_of(const vector<string> &symbols, const SetMap &first,
+                const unordered_set<string> &nullable, const SetMap &made)
+    -> unordered_set<string> {
+    unordered_set<string> predict;
+    for (const string &symbol : symbols) {
+        auto found = made.find(symbol);
+        const unordered_set<string> &symbol_first =
+            found != made.end() ? found->second : first.at(symbol);
+        for (const string &term : symbol_first) {
+            if (!term.empty()) {
+                util::insert_missing(predict, term);
+            }
+        }
+        bool symbol_nullable = found != made.end()
+                                   ? symbol_first.count("") == 1
+                                   : nullable.count(symbol) == 1;
+        if (!symbol_nullable) {
+            return predict;
+        }
+    }
+    predict.insert("");
+    return predict;
+}
+
+auto overlaps(const unordered_set<string> &a, const unordered_set<string> &b)
+    -> bool {
+    const unordered_set<string> &smaller = a.size() <= b.size() ? a : b;
+    const unordered_set<string> &larger = a.size() <= b.size() ? b : a;
+    for (const string &element : smaller) {
+        if (larger.count(element) == 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Factoring names new nts A1, A2, ... after A, so one can only clash with
+// another nt when some nt's name is another's followed by digits
+auto has_digit_suffixed_non_term(const unordered_set<string> &non_terms)
+    -> bool {
+    for (const string &non_term : non_terms) {
+        size_t end = non_term.size();
+        while (end > 0 && std::isdigit(static_cast<unsigned char>(
+                              non_term[end - 1])) != 0) {
+            end--;
+            if (non_terms.count(non_term.substr(0, end)) == 1) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 namespace analysis {
 
-auto print_nullable_set(const Grammar &grammar) -> void {
+auto print_nullable_set(const Grammar &grammar, std::ostream &out) -> void {
     auto nullable = calc_nullable(grammar);
-    std::vector<std::string> nullable_order =
-        util::generate_ordered_vec(nullable, grammar.non_term_order);
-    std::string nullable_string = util::join_vec_string(nullable_order, ", ");
-    std::cout << "Nullable = { " << nullable_string << " }";
+    std::vector<const std::string *> nullable_order =
+        util::generate_ordered_vec(nullable,
+                                   util::rank_index(grammar.non_term_order));
+    out << "Nullable = { ";
+    for (size_t i = 0; i < nullable_order.size(); i++) {
+        if (i > 0) {
+            out << ", ";
+        }
+        out << *nullable_order[i];
+    }
+    out << " }";
 }
 
 auto calc_nullable(const Grammar &grammar) -> std::unordered_set<std::string> {
@@ -30,9 +212,13 @@ auto calc_nullable(const Grammar &grammar) -> std::unordered_set<std::string> {
 
     // Main Loop
     bool changed = true;
+    size_t pass = 0;
     while (changed) {
         changed = false;
+        budget::check("nullable pass", ++pass, 0);
+        size_t before = nullable.size();
         for (const Rule &rule : grammar.rules) {
+            budget::poll("nullable pass", pass, 0);
             // Skip over what's already nullable
             if (nullable.count(rule.lhs) == 1) {
                 continue;
@@ -43,47 +229,58 @@ auto calc_nullable(const Grammar &grammar) -> std::unordered_set<std::string> {
                 changed = true;
             }
         }
+        PROBE3(nullable_pass, pass, nullable.size() - before, nullable.size());
     }
 
     return nullable;
 }
 
-auto print_first_sets(const Grammar &grammar) -> void {
+auto print_first_sets(const Grammar &grammar, std::ostream &out) -> void {
     auto first = calc_first(grammar);
-    print_set_map(first, grammar, "FIRST");
+    print_set_map(first, grammar, "FIRST", out);
 }
 
 auto calc_first(const Grammar &grammar) -> SetMap {
     auto nullable = calc_nullable(grammar);
     SetMap first;
+    first.reserve(grammar.terms.size() + grammar.non_terms.size());
 
-    // Init Terminals
+    // Init Terminals, and an empty set per nonterminal so the loop below
+    // only looks sets up
     for (const auto &term : grammar.terms) {
         first[term].insert(term);
     }
+    for (const auto &non_term : grammar.non_terms) {
+        first[non_term];
+    }
 
     // Main Loop
     bool changed = true;
+    size_t pass = 0;
+    size_t elements = grammar.terms.size();
     while (changed) {
         changed = false;
+        budget::check("FIRST pass", ++pass, 0);
+        size_t added = 0;
 
         // Loop through all rules
         for (const Rule &rule : grammar.rules) {
-            const std::string lhs = rule.lhs;
-            size_t old_size = first[lhs].size();
+            budget::poll("FIRST pass", pass, 0);
+            auto &lhs_first = first[rule.lhs];
+            size_t old_size = lhs_first.size();
             // ...and all symbols in the rhs of those rules
             for (const std::string &symbol : rule.rhs) {
 
                 // If the current symbol is a terminal, add it to the first set
                 // of this non_term and break
                 if (grammar.terms.count(symbol) == 1) {
-                    first[lhs].insert(symbol);
+                    util::insert_missing(lhs_first, symbol);
                     break;
                 }
 
                 // Otherwise if the symbol is a non-terminal, add its first set
                 // to first(lhs)
-                util::merge_sets(first[lhs], first[symbol]);
+                util::merge_sets(lhs_first, first[symbol]);
 
                 if (nullable.count(symbol) == 0) {
                     break; // If symbol is not nullable, don't check further
@@ -91,65 +288,97 @@ auto calc_first(const Grammar &grammar) -> SetMap {
                 }
             }
             // If a first set changed, we need to loop
-            if (old_size != first[lhs].size()) {
+            if (old_size != lhs_first.size()) {
                 changed = true;
+                added += lhs_first.size() - old_size;
             }
         }
+        elements += added;
+        PROBE3(first_pass, pass, added, elements);
     }
 
     return first;
 }
 
-auto print_follow_sets(const Grammar &grammar) -> void {
+auto print_follow_sets(const Grammar &grammar, std::ostream &out) -> void {
     auto follow = calc_follow(grammar);
-    print_set_map(follow, grammar, "FOLLOW");
+    print_set_map(follow, grammar, "FOLLOW", out);
 }
 
 auto calc_follow(const Grammar &grammar) -> SetMap {
     auto nullable = calc_nullable(grammar);
     auto first = calc_first(grammar);
 
+    const InternedGrammar interned = intern_grammar(grammar);
+    const SuffixFirstTable suffixes =
+        build_suffix_first(interned, first, nullable);
+
+    // Every nonterminal gets a set, even one no rhs mentions
     SetMap follow;
+    follow.reserve(grammar.non_term_order.size());
+    for (const std::string &non_term : grammar.non_term_order) {
+        follow[non_term];
+    }
     follow[grammar.non_term_order[0]].insert("$");
 
     // Initialization: Rules IV and V
-    for (const Rule &rule : grammar.rules) {
+    for (size_t r = 0; r < grammar.rules.size(); r++) {
+        budget::poll("FOLLOW initialization rule", r + 1, grammar.rules.size());
+        const Rule &rule = grammar.rules[r];
         for (size_t i = 0; i < rule.rhs.size(); i++) {
-            const std::string symbol = rule.rhs[i];
+            const std::string &symbol = rule.rhs[i];
             // Skip over terminals
             if (grammar.terms.count(symbol) == 1) {
                 continue;
             }
             // Rule IV + V
-            util::merge_sets(follow[symbol],
-                             first_of_subset(rule.rhs, i + 1, first, nullable));
+            const SuffixFirst &rest = suffixes.at(r, i + 1);
+            auto &symbol_follow = follow[symbol];
+            std::for_each(suffixes.first_begin(rest), suffixes.first_end(rest),
+                          [&](int term) {
+                              util::insert_missing(symbol_follow,
+                                                   interned.names[term]);
+                          });
         }
     }
 
+    size_t elements = 0;
+    for (const auto &pair : follow) {
+        elements += pair.second.size();
+    }
+    PROBE1(follow_init, elements);
+
     // Main Loop: Apply rules II and III until nothing changes
     bool changed = true;
+    size_t pass = 0;
     while (changed) {
         changed = false;
+        budget::check("FOLLOW pass", ++pass, 0);
+        size_t added = 0;
         // Loop through rules
         for (const Rule &rule : grammar.rules) {
+            budget::poll("FOLLOW pass", pass, 0);
+            const auto &lhs_follow = follow[rule.lhs];
             // ...and all symbols in those rules in reverse order
             for (int i = rule.rhs.size() - 1; i >= 0; i--) {
-                const std::string symbol = rule.rhs[i];
+                const std::string &symbol = rule.rhs[i];
 
                 // Break on terminals
                 if (grammar.terms.count(symbol) == 1) {
                     break;
                 }
 
-                size_t old_size = follow[symbol].size();
+                auto &symbol_follow = follow[symbol];
+                size_t old_size = symbol_follow.size();
 
                 // Rule II and III
-                util::merge_sets(follow[symbol], follow[rule.lhs]);
+                util::merge_sets(symbol_follow, lhs_follow);
 
                 // If set sizes changed, we'll need to loop through all rules
                 // again
-                if (follow[symbol].size() != old_size) {
+                if (symbol_follow.size() != old_size) {
                     changed = true;
+                    added += symbol_follow.size() - old_size;
                 }
 
                 // If this isn't nullable, then stop
@@ -158,23 +387,122 @@ auto calc_follow(const Grammar &grammar) -> SetMap {
                 }
             }
         }
+        elements += added;
+        PROBE3(follow_pass, pass, added, elements);
     }
 
     return follow;
 }
 
-auto print_left_factored_grammar(const Grammar &grammar) -> void {
+auto print_left_factored_grammar(const Grammar &grammar, std::ostream &out)
+    -> void {
     auto factored_rules = calc_left_factored(grammar);
-    print_rules(factored_rules);
+    print_rules(factored_rules, out);
 }
 
-auto print_grammar_without_left_recursion(const Grammar &grammar) -> void {
+auto print_grammar_without_left_recursion(const Grammar &grammar,
+                                          std::ostream &out) -> void {
     auto rules = eliminate_left_recursion(grammar);
-    print_rules(rules);
+    print_rules(rules, out);
 }
 
 auto calc_left_factored(Grammar grammar) -> vector<Rule> {
-    RuleMap rule_map = gen_rule_map(grammar.rules);
+    // grammar.rules stays whole for the sequential fallback, if it can happen
+    const bool may_clash = has_digit_suffixed_non_term(grammar.non_terms);
+    RuleMap rule_map = may_clash ? gen_rule_map(grammar.rules)
+                                 : gen_rule_map(std::move(grammar.rules));
+    const vector<string> &non_terms = grammar.non_term_order;
+
+    // Each non_term is factored on its own, so they can run in parallel
+    vector<vector<Rule>> factored(non_terms.size());
+    vector<vector<string>> new_nts(non_terms.size());
+    util::parallel_for(non_terms.size(), [&](size_t i) {
+        budget::check("left factoring nonterminal", i + 1, non_terms.size());
+        PROBE2(factor_start, i, non_terms[i].c_str());
+        // Each index owns its own entry, so moving it out is race free
+        factored[i] = left_factor_non_term(
+            non_terms[i], std::move(rule_map.at(non_terms[i])), new_nts[i]);
+        PROBE3(factor_done, i, non_terms[i].c_str(), factored[i].size());
+    });
+
+    // A new nt that clashes with another nt would have shared its rule set
+    // with it, which only the sequential interleaving reproduces
+    if (may_clash) {
+        unordered_set<string> names(grammar.non_terms);
+        for (const vector<string> &nts : new_nts) {
+            for (const string &nt : nts) {
+                if (!names.insert(nt).second) {
+                    return calc_left_factored_sequential(std::move(grammar));
+                }
+            }
+        }
+    }
+
+    // Merge in non_term_order so the output doesn't depend on scheduling
+    vector<Rule> res;
+    for (vector<Rule> &rules : factored) {
+        std::move(rules.begin(), rules.end(), std::back_inserter(res));
+    }
+    return res;
+}
+
+auto left_factor_non_term(const string &non_term,
+                          unordered_set<Rule, RuleHasher> rules,
+                          vector<string> &new_nts) -> vector<Rule> {
+    RuleMap rule_map;
+    rule_map[non_term] = std::move(rules);
+
+    while (true) {
+        vector<string> prefix = longest_shared_prefix(rule_map.at(non_term));
+
+        // If no prefix, then we've fully left-factored this non_term
+        if (prefix.empty()) {
+            break;
+        }
+
+        vector<vector<string>> postfixes =
+            postfix_of_rules_with_prefix(rule_map.at(non_term), prefix);
+        charge_factoring(postfixes, prefix.size(), new_nts.size() + 1);
+
+        string new_nt = non_term + std::to_string(new_nts.size() + 1);
+        new_nts.push_back(new_nt);
+
+        // Remove all rules A -> prefix postfix1 | prefix postfix2
+        erase_rules_that_start_with(prefix, rule_map.at(non_term));
+
+        // add A -> prefix A1
+        IDList new_rhs = std::move(prefix);
+        new_rhs.push_back(new_nt);
+        rule_map[non_term].emplace(non_term, std::move(new_rhs));
+
+        // add A1 -> postfix1 | postfix2 | postfix3
+        auto &new_nt_rules = rule_map[new_nt];
+        for (auto &postfix : postfixes) {
+            new_nt_rules.emplace(new_nt, std::move(postfix));
+        }
+    }
+
+    // A's rules first, then A1, A2, ...
+    vector<Rule> res;
+    move_rules(rule_map.at(non_term), res);
+    for (const string &new_nt : new_nts) {
+        move_rules(rule_map.at(new_nt), res);
+    }
+    return res;
+}
+
+auto calc_left_factored_sequential(Grammar grammar) -> vector<Rule> {
+    RuleMap rule_map = gen_rule_map(std::move(grammar.rules));
+
+    // Every non_term starts in the first round, and each factoring step
+    // nets it one rule, which is how factor_done counts them
+    const vector<string> &non_terms = grammar.non_term_order;
+    const util::RankIndex rank = util::rank_index(non_terms);
+    vector<size_t> start_rules(non_terms.size());
+    for (size_t i = 0; i < non_terms.size(); i++) {
+        start_rules[i] = rule_map.at(non_terms[i]).size();
+        PROBE2(factor_start, i, non_terms[i].c_str());
+    }
 
     unordered_map<string, int> factored_count;
 
@@ -187,31 +515,33 @@ auto calc_left_factored(Grammar grammar) -> vector<Rule> {
             // If no prefix, then we've fully left-factored this non_term
             if (prefix.empty()) {
                 nts_to_remove.push_back(curr_nt);
+                size_t i = rank.at(curr_nt);
+                PROBE3(factor_done, i, curr_nt.c_str(),
+                       start_rules[i] + factored_count[curr_nt]);
                 continue;
             }
 
             vector<vector<string>> postfixes =
                 postfix_of_rules_with_prefix(rule_map.at(curr_nt), prefix);
+            charge_factoring(postfixes, prefix.size(),
+                             factored_count[curr_nt] + 1);
 
             string new_nt =
                 curr_nt + std::to_string(factored_count[curr_nt] + 1);
             factored_count[curr_nt]++;
 
             // Remove all rules A -> prefix postfix1 | prefix postfix2
-            vector<Rule> rules_to_remove =
-                all_rules_that_start_with(prefix, rule_map.at(curr_nt));
-            for (const Rule &rule : rules_to_remove) {
-                rule_map.at(curr_nt).erase(rule);
-            }
+            erase_rules_that_start_with(prefix, rule_map.at(curr_nt));
 
             // add A -> prefix A1
-            IDList new_rhs = prefix;
+            IDList new_rhs = std::move(prefix);
             new_rhs.push_back(new_nt);
-            rule_map[curr_nt].emplace(curr_nt, new_rhs);
+            rule_map[curr_nt].emplace(curr_nt, std::move(new_rhs));
 
             // add A1 -> postfix1 | postfix2 | postfix3
-            for (const auto &postfix : postfixes) {
-                rule_map[new_nt].emplace(new_nt, postfix);
+            auto &new_nt_rules = rule_map[new_nt];
+            for (auto &postfix : postfixes) {
+                new_nt_rules.emplace(new_nt, std::move(postfix));
             }
         }
 
@@ -220,34 +550,150 @@ auto calc_left_factored(Grammar grammar) -> vector<Rule> {
         }
     }
 
-    return rule_map_to_vec(rule_map);
+    return rule_map_to_vec(std::move(rule_map));
 }
 
-auto longest_shared_prefix(const unordered_set<Rule, RuleHasher> &rules)
-    -> vector<string> {
-    vector<string> longest_prefix;
-    string longest_prefix_string;
-    for (const Rule &rule1 : rules) {
-        for (const Rule &rule2 : rules) {
-            if (rule1 == rule2) {
+auto calc_left_factored_conflicts(Grammar grammar) -> vector<Rule> {
+    const SetMap first = calc_first(grammar);
+    const unordered_set<string> nullable = calc_nullable(grammar);
+    RuleMap rule_map = gen_rule_map(std::move(grammar.rules));
+    const vector<string> &non_terms = grammar.non_term_order;
+
+    vector<vector<Rule>> factored(non_terms.size());
+    vector<vector<string>> new_nts(non_terms.size());
+    util::parallel_for(non_terms.size(), [&](size_t i) {
+        budget::check("left factoring nonterminal", i + 1, non_terms.size());
+        PROBE2(factor_start, i, non_terms[i].c_str());
+        factored[i] = left_factor_conflicts_non_term(
+            non_terms[i], std::move(rule_map.at(non_terms[i])), first,
+            nullable, grammar.non_terms, new_nts[i]);
+        PROBE3(factor_done, i, non_terms[i].c_str(), factored[i].size());
+    });
+
+    // New nts only avoid the grammar's nts, so A's A12 can clash with A1's
+    // A12. The later one, in non_term_order, is renamed.
+    unordered_set<string> taken(grammar.non_terms);
+    for (size_t i = 0; i < non_terms.size(); i++) {
+        unordered_set<string> own(new_nts[i].begin(), new_nts[i].end());
+        unordered_map<string, string> renamed;
+        size_t suffix = 0;
+        for (const string &nt : new_nts[i]) {
+            if (taken.insert(nt).second) {
                 continue;
             }
+            string name;
+            do {
+                name = non_terms[i] + std::to_string(++suffix);
+            } while (taken.count(name) == 1 || own.count(name) == 1);
+            taken.insert(name);
+            renamed[nt] = name;
+        }
+        if (renamed.empty()) {
+            continue;
+        }
+        for (Rule &rule : factored[i]) {
+            auto found = renamed.find(rule.lhs);
+            if (found != renamed.end()) {
+                rule.lhs = found->second;
+            }
+            for (string &symbol : rule.rhs) {
+                found = renamed.find(symbol);
+                if (found != renamed.end()) {
+                    symbol = found->second;
+                }
+            }
+        }
+    }
 
-            vector<string> candidate_prefix = rule2.longest_prefix_with(rule1);
-            string candidate_prefix_string =
-                util::join_vec_string(candidate_prefix, "");
+    // Merge in non_term_order so the output doesn't depend on scheduling
+    vector<Rule> res;
+    for (vector<Rule> &rules : factored) {
+        std::move(rules.begin(), rules.end(), std::back_inserter(res));
+    }
+    return res;
+}
 
-            // This prefix must be either larger than curr_largest or equal in
-            // size but lower in lexicographic value
-            if (candidate_prefix.size() > longest_prefix.size() ||
-                (candidate_prefix.size() == longest_prefix.size() &&
-                 candidate_prefix_string < longest_prefix_string)) {
-                longest_prefix = candidate_prefix;
-                longest_prefix_string = candidate_prefix_string;
+auto left_factor_conflicts_non_term(const string &non_term,
+                                    unordered_set<Rule, RuleHasher> rules,
+                                    const SetMap &first,
+                                    const unordered_set<string> &nullable,
+                                    const unordered_set<string> &non_terms,
+                                    vector<string> &new_nts) -> vector<Rule> {
+    RuleMap rule_map;
+    rule_map[non_term] = std::move(rules);
+    SetMap made; // predict sets of the new nts' rules, merged
+    size_t suffix = 0;
+
+    // non_term, then each new nt as it is made, so the postfixes of a
+    // factored group are checked again in their own nonterminal
+    for (size_t i = 0; i <= new_nts.size(); i++) {
+        const string current = i == 0 ? non_term : new_nts[i - 1];
+        auto &current_rules = rule_map.at(current);
+        while (true) {
+            // Only pairs that share a longer prefix than the best so far
+            // are asked, so most rules never need their predict set
+            unordered_map<const Rule *, unordered_set<string>> predicts;
+            auto clash = [&](const Rule &rule1, const Rule &rule2) -> bool {
+                for (const Rule *rule : {&rule1, &rule2}) {
+                    if (predicts.count(rule) == 0) {
+                        predicts[rule] =
+                            predict_of(rule->rhs, first, nullable, made);
+                    }
+                }
+                return overlaps(predicts.at(&rule1), predicts.at(&rule2));
+            };
+            vector<string> prefix = longest_prefix_where(current_rules, clash);
+
+            // No two rules that clash share a prefix
+            if (prefix.empty()) {
+                break;
+            }
+
+            vector<vector<string>> postfixes =
+                postfix_of_rules_with_prefix(current_rules, prefix);
+            charge_factoring(postfixes, prefix.size(), new_nts.size() + 1);
+
+            string new_nt;
+            do {
+                new_nt = non_term + std::to_string(++suffix);
+            } while (non_terms.count(new_nt) == 1);
+            new_nts.push_back(new_nt);
+
+            auto &new_first = made[new_nt];
+            for (const vector<string> &postfix : postfixes) {
+                util::merge_sets(new_first,
+                                 predict_of(postfix, first, nullable, made));
+            }
+
+            // Remove all rules A -> prefix postfix1 | prefix postfix2
+            erase_rules_that_start_with(prefix, current_rules);
+
+            // add A -> prefix A1
+            IDList new_rhs = std::move(prefix);
+            new_rhs.push_back(new_nt);
+            current_rules.emplace(current, std::move(new_rhs));
+
+            // add A1 -> postfix1 | postfix2 | postfix3
+            auto &new_nt_rules = rule_map[new_nt];
+            for (auto &postfix : postfixes) {
+                new_nt_rules.emplace(new_nt, std::move(postfix));
             }
         }
     }
-    return longest_prefix;
+
+    // A's rules first, then A1, A2, ...
+    vector<Rule> res;
+    move_rules(rule_map.at(non_term), res);
+    for (const string &new_nt : new_nts) {
+        move_rules(rule_map.at(new_nt), res);
+    }
+    return res;
+}
+
+auto longest_shared_prefix(const unordered_set<Rule, RuleHasher> &rules)
+    -> vector<string> {
+    return longest_prefix_where(
+        rules, [](const Rule &, const Rule &) -> bool { return true; });
 }
 
 auto postfix_of_rules_with_prefix(const unordered_set<Rule, RuleHasher> &rules,
@@ -264,38 +710,50 @@ auto postfix_of_rules_with_prefix(const unordered_set<Rule, RuleHasher> &rules,
     return postfixes;
 }
 
-auto all_rules_that_start_with(const vector<string> &prefix,
-                               const unordered_set<Rule, RuleHasher> &rules)
-    -> vector<Rule> {
-    vector<Rule> res;
-    for (const Rule &rule : rules) {
-        if (rule.starts_with(prefix)) {
-            res.push_back(rule);
+auto erase_rules_that_start_with(const vector<string> &prefix,
+                                 unordered_set<Rule, RuleHasher> &rules)
+    -> void {
+    for (auto it = rules.begin(); it != rules.end();) {
+        if (it->starts_with(prefix)) {
+            it = rules.erase(it);
+        } else {
+            ++it;
         }
     }
-    return res;
 }
 
 auto eliminate_left_recursion(Grammar grammar) -> vector<Rule> {
     // Setup
-    RuleMap rule_map = gen_rule_map(grammar.rules);
+    RuleMap rule_map = gen_rule_map(std::move(grammar.rules));
     std::sort(grammar.non_term_order.begin(), grammar.non_term_order.end());
     const vector<string> &non_terms = grammar.non_term_order;
 
     for (size_t i = 0; i < non_terms.size(); i++) {
         const string &curr_nt = non_terms[i];
         auto &curr_nt_rules = rule_map.at(curr_nt);
+        PROBE3(unleftrec_start, i, curr_nt.c_str(), curr_nt_rules.size());
 
         // Eliminate Indirect Left Recursion (rule for a non_term can't
         // start with a previous non_term)
         for (size_t j = 0; j < i; j++) {
+            budget::poll("left recursion nonterminal", i + 1,
+                         non_terms.size());
 
             const string &prev_nt = non_terms[j];
-            vector<Rule> rules_to_add;
-            vector<Rule> rules_to_remove;
-            for (const Rule &curr_rule : curr_nt_rules) {
+            if (std::none_of(curr_nt_rules.begin(), curr_nt_rules.end(),
+                             [&prev_nt](const Rule &rule) -> bool {
+                                 return rule.starts_with(prev_nt);
+                             })) {
+                continue;
+            }
 
+            // Every rule is moved out and back, so a replaced rule can hand
+            // the rest of its rhs on instead of copying it once per pass
+            vector<Rule> curr_rules;
+            move_rules(curr_nt_rules, curr_rules);
+            for (Rule &curr_rule : curr_rules) {
                 if (!curr_rule.starts_with(prev_nt)) {
+                    curr_nt_rules.insert(std::move(curr_rule));
                     continue;
                 }
 
@@ -303,48 +761,47 @@ auto eliminate_left_recursion(Grammar grammar) -> vector<Rule> {
                 // rhs
                 // (i.e if B -> Ac and A -> d, replace B -> Ac with B -> dc)
                 vector<Rule> new_rules = replace_nt_for_rhs(
-                    curr_rule, prev_nt, rule_map.at(prev_nt));
-
-                rules_to_add.insert(rules_to_add.end(), new_rules.begin(),
-                                    new_rules.end());
-                rules_to_remove.push_back(curr_rule);
-            }
-
-            for (const Rule &rule : rules_to_remove) {
-                curr_nt_rules.erase(rule);
-            }
+                    std::move(curr_rule), prev_nt, rule_map.at(prev_nt));
+                budget::charge(new_rules.size(), rules_bytes(new_rules),
+                               "left recursion nonterminal", i + 1,
+                               non_terms.size());
 
-            for (const Rule &rule : rules_to_add) {
-                curr_nt_rules.insert(rule);
+                for (Rule &rule : new_rules) {
+                    curr_nt_rules.insert(std::move(rule));
+                }
             }
         }
 
         // Then Eliminate Direct Left Recursion
-        std::pair<vector<Rule>, vector<Rule>> pair =
-            split_by_left_recurse(curr_nt_rules);
-        auto &recurse_rules = pair.first;
-        auto &non_recurse_rules = pair.second;
-
-        if (recurse_rules.empty()) {
-            continue;
-        }
-
-        string new_nt = curr_nt + "1";
-        rule_map[new_nt] =
-            generate_recursed_new_nt_rules(recurse_rules, new_nt);
-
-        for (const Rule &recurse_rule : recurse_rules) {
-            curr_nt_rules.erase(recurse_rule);
-        }
-
-        for (Rule &non_recurse_rule : non_recurse_rules) {
-            curr_nt_rules.erase(non_recurse_rule);
-            non_recurse_rule.rhs.push_back(new_nt);
-            curr_nt_rules.insert(non_recurse_rule);
+        size_t new_nt_rules = 0;
+        if (std::any_of(curr_nt_rules.begin(), curr_nt_rules.end(),
+                        [](const Rule &rule) -> bool {
+                            return rule.starts_with(rule.lhs);
+                        })) {
+            // Every rule of curr_nt changes, so they are all moved out
+            std::pair<vector<Rule>, vector<Rule>> pair =
+                split_by_left_recurse(std::move(curr_nt_rules));
+            auto &recurse_rules = pair.first;
+            auto &non_recurse_rules = pair.second;
+
+            string new_nt = curr_nt + "1";
+            rule_map[new_nt] =
+                generate_recursed_new_nt_rules(recurse_rules, new_nt);
+            new_nt_rules = rule_map[new_nt].size();
+            budget::charge(new_nt_rules, rules_bytes(rule_map[new_nt]),
+                           "left recursion nonterminal", i + 1,
+                           non_terms.size());
+
+            for (Rule &non_recurse_rule : non_recurse_rules) {
+                non_recurse_rule.rhs.push_back(new_nt);
+                curr_nt_rules.insert(std::move(non_recurse_rule));
+            }
         }
+        PROBE3(unleftrec_done, i, curr_nt.c_str(),
+               curr_nt_rules.size() + new_nt_rules);
     }
 
-    return rule_map_to_vec(rule_map);
+    return rule_map_to_vec(std::move(rule_map));
 }
 
 auto generate_recursed_new_nt_rules(const vector<Rule> &recurse_rules,
@@ -357,7 +814,7 @@ auto generate_recursed_new_nt_rules(const vector<Rule> &recurse_rules,
         new_rule.rhs.insert(new_rule.rhs.end(), rule.rhs.begin() + 1,
                             rule.rhs.end());
         new_rule.rhs.push_back(new_nt);
-        new_rules.insert(new_rule);
+        new_rules.insert(std::move(new_rule));
     }
     // Add the epsilon rule (A1 -> epsilon) to provide a end point for the
     // derivation
@@ -365,7 +822,7 @@ auto generate_recursed_new_nt_rules(const vector<Rule> &recurse_rules,
     return new_rules;
 }
 
-auto replace_nt_for_rhs(const Rule &rule, const string &nt_to_replace,
+auto replace_nt_for_rhs(Rule &&rule, const string &nt_to_replace,
                         const unordered_set<Rule, RuleHasher> &nt_rules)
     -> vector<Rule> {
 
@@ -374,48 +831,144 @@ auto replace_nt_for_rhs(const Rule &rule, const string &nt_to_replace,
     }
 
     vector<Rule> replaced_rules;
+    replaced_rules.reserve(nt_rules.size());
+    size_t left = nt_rules.size();
     for (const Rule &nt_rule : nt_rules) {
-        Rule new_rule{rule.lhs, IDList()};
+        bool last = --left == 0;
+        IDList rhs;
+        rhs.reserve(nt_rule.rhs.size() + rule.rhs.size() - 1);
         // Replace NT with one of its rhs
-        new_rule.rhs.insert(new_rule.rhs.end(), nt_rule.rhs.begin(),
-                            nt_rule.rhs.end());
+        rhs.insert(rhs.end(), nt_rule.rhs.begin(), nt_rule.rhs.end());
         // Add the rest of the OG rule (after the nt_to_replace)
-        new_rule.rhs.insert(new_rule.rhs.end(), rule.rhs.begin() + 1,
-                            rule.rhs.end());
-        replaced_rules.push_back(new_rule);
+        if (last) {
+            rhs.insert(rhs.end(), std::make_move_iterator(rule.rhs.begin() + 1),
+                       std::make_move_iterator(rule.rhs.end()));
+            replaced_rules.emplace_back(std::move(rule.lhs), std::move(rhs));
+        } else {
+            rhs.insert(rhs.end(), rule.rhs.begin() + 1, rule.rhs.end());
+            replaced_rules.emplace_back(rule.lhs, std::move(rhs));
+        }
     }
     return replaced_rules;
 }
 
-auto split_by_left_recurse(const unordered_set<Rule, RuleHasher> &rules)
+// Leaves rules empty
+auto split_by_left_recurse(unordered_set<Rule, RuleHasher> &&rules)
     -> std::pair<vector<Rule>, vector<Rule>> {
+    vector<Rule> all;
+    move_rules(rules, all);
     std::pair<vector<Rule>, vector<Rule>> pair;
-    for (const Rule &rule : rules) {
+    for (Rule &rule : all) {
         if (!rule.starts_with(rule.lhs)) {
-            pair.second.push_back(rule);
+            pair.second.push_back(std::move(rule));
         } else {
-            pair.first.push_back(rule);
+            pair.first.push_back(std::move(rule));
         }
     }
     return pair;
 }
 
+auto print_reduced_grammar(const Grammar &grammar, std::ostream &out) -> void {
+    auto reduced = remove_useless_symbols(grammar);
+    print_rules(reduced.rules, out);
+}
+
+auto remove_useless_symbols(const Grammar &grammar) -> Grammar {
+    // Productive: worklist over rules, counting rhs nonterminals that aren't
+    // known to be productive yet. Each occurrence is decremented once.
+    vector<size_t> pending(grammar.rules.size(), 0);
+    unordered_map<string, vector<size_t>> occurrences;
+    unordered_set<string> productive;
+    vector<string> worklist;
+    for (size_t r = 0; r < grammar.rules.size(); r++) {
+        const Rule &rule = grammar.rules[r];
+        for (const string &symbol : rule.rhs) {
+            if (grammar.non_terms.count(symbol) == 1) {
+                pending[r]++;
+                occurrences[symbol].push_back(r);
+            }
+        }
+        if (pending[r] == 0 && productive.insert(rule.lhs).second) {
+            worklist.push_back(rule.lhs);
+        }
+    }
+    while (!worklist.empty()) {
+        string non_term = std::move(worklist.back());
+        worklist.pop_back();
+        for (size_t r : occurrences[non_term]) {
+            const string &lhs = grammar.rules[r].lhs;
+            if (--pending[r] == 0 && productive.insert(lhs).second) {
+                worklist.push_back(lhs);
+            }
+        }
+    }
+
+    // Reachable: BFS from the start symbol through productive rules only
+    RuleMap rule_map;
+    for (size_t r = 0; r < grammar.rules.size(); r++) {
+        if (pending[r] == 0) {
+            rule_map[grammar.rules[r].lhs].insert(grammar.rules[r]);
+        }
+    }
+    unordered_set<string> reachable;
+    vector<string> queue;
+    if (productive.count(grammar.non_term_order[0]) == 1) {
+        reachable.insert(grammar.non_term_order[0]);
+        queue.push_back(grammar.non_term_order[0]);
+    }
+    for (size_t i = 0; i < queue.size(); i++) {
+        for (const Rule &rule : rule_map.at(queue[i])) {
+            for (const string &symbol : rule.rhs) {
+                if (reachable.insert(symbol).second &&
+                    grammar.non_terms.count(symbol) == 1) {
+                    queue.push_back(symbol);
+                }
+            }
+        }
+    }
+
+    Grammar reduced;
+    for (size_t r = 0; r < grammar.rules.size(); r++) {
+        if (pending[r] == 0 && reachable.count(grammar.rules[r].lhs) == 1) {
+            reduced.rules.push_back(grammar.rules[r]);
+        }
+    }
+    for (const string &non_term : grammar.non_term_order) {
+        if (reachable.count(non_term) == 1) {
+            reduced.non_terms.insert(non_term);
+            reduced.non_term_order.push_back(non_term);
+        }
+    }
+    for (const string &term : grammar.term_order) {
+        if (reachable.count(term) == 1) {
+            reduced.terms.insert(term);
+            reduced.term_order.push_back(term);
+        }
+    }
+    return reduced;
+}
+
 //
 // ========= Util =========
 //
 
 auto print_set_map(const SetMap &map, const Grammar &grammar,
-                   const std::string &set_name) -> void {
+                   const std::string &set_name, std::ostream &out) -> void {
+    const util::RankIndex term_rank = util::rank_index(grammar.term_order);
     for (size_t i = 0; i < grammar.non_term_order.size(); i++) {
-        const std::string non_term = grammar.non_term_order[i];
+        const std::string &non_term = grammar.non_term_order[i];
+        out << set_name << "(" << non_term << ") = { ";
         auto first_order =
-            util::generate_ordered_vec(map.at(non_term), grammar.term_order);
-        std::string first_order_string =
-            util::join_vec_string(first_order, ", ");
-        std::cout << set_name << "(" << non_term << ") = { "
-                  << first_order_string << " }";
+            util::generate_ordered_vec(map.at(non_term), term_rank);
+        for (size_t j = 0; j < first_order.size(); j++) {
+            if (j > 0) {
+                out << ", ";
+            }
+            out << *first_order[j];
+        }
+        out << " }";
         if (i < grammar.non_term_order.size() - 1) {
-            std::cout << "\n";
+            out << "\n";
         }
     }
 }
@@ -428,25 +981,6 @@ auto all_nullable(const std::vector<std::string> &symbols,
                        });
 }
 
-// Returns the First set for a series of symbols (i.e. First(ABCD))
-auto first_of_subset(const std::vector<std::string> &symbols,
-                     const size_t start_idx, const SetMap &first,
-                     const std::unordered_set<std::string> &nullable)
-    -> std::unordered_set<std::string> {
-    std::unordered_set<std::string> subset_first;
-
-    for (size_t i = start_idx; i < symbols.size(); i++) {
-        const std::string &symbol = symbols[i];
-        // Add this symbols first to subset_first
-        subset_first.insert(first.at(symbol).begin(), first.at(symbol).end());
-        // Stop when the symbol is not nullable
-        if (nullable.count(symbol) == 0) {
-            break;
-        }
-    }
-    return subset_first;
-}
-
 auto gen_rule_map(const vector<Rule> &rules) -> RuleMap {
     RuleMap rule_map;
     for (const Rule &rule : rules) {
@@ -455,12 +989,37 @@ auto gen_rule_map(const vector<Rule> &rules) -> RuleMap {
     return rule_map;
 }
 
-auto print_rules(vector<Rule> &rules) -> void {
-    vector<string> rule_strings(rules.size());
-    std::transform(rules.begin(), rules.end(), rule_strings.begin(),
-                   [](const Rule &rule) -> string { return rule.to_string(); });
-    std::sort(rule_strings.begin(), rule_strings.end());
-    std::cout << util::join_vec_string(rule_strings, "\n");
+auto gen_rule_map(vector<Rule> &&rules) -> RuleMap {
+    RuleMap rule_map;
+    for (Rule &rule : rules) {
+        auto &lhs_rules = rule_map[rule.lhs];
+        lhs_rules.insert(std::move(rule));
+    }
+    rules.clear();
+    return rule_map;
+}
+
+// Sorted by text, as the rules' strings would sort, but compared and
+// written in place
+auto print_rules(vector<Rule> &rules, std::ostream &out) -> void {
+    output::sort_rules_as_text(rules);
+    for (size_t i = 0; i < rules.size(); i++) {
+        if (i > 0) {
+            out << "\n";
+        }
+        print_rule(rules[i], out);
+    }
+}
+
+auto print_rule(const Rule &rule, std::ostream &out) -> void {
+    out << rule.lhs << " -> ";
+    for (size_t i = 0; i < rule.rhs.size(); i++) {
+        if (i > 0) {
+            out << " ";
+        }
+        out << rule.rhs[i];
+    }
+    out << " #";
 }
 
 auto rule_map_to_vec(const RuleMap &rule_map) -> vector<Rule> {
@@ -473,4 +1032,47 @@ auto rule_map_to_vec(const RuleMap &rule_map) -> vector<Rule> {
     return res;
 }
 
+auto rule_map_to_vec(RuleMap &&rule_map) -> vector<Rule> {
+    size_t size = 0;
+    for (const auto &pair : rule_map) {
+        size += pair.second.size();
+    }
+    vector<Rule> res;
+    res.reserve(size);
+    for (auto &pair : rule_map) {
+        move_rules(pair.second, res);
+    }
+    return res;
+}
+
+// Rebuilds a Grammar from its rules. Visiting each rule's lhs then rhs sees
+// symbols in the same order the parser first reads them.
+auto grammar_from_rules(vector<Rule> rules) -> Grammar {
+    Grammar grammar;
+    unordered_set<string> universe;
+    vector<string> universe_order;
+    for (const Rule &rule : rules) {
+        grammar.non_terms.insert(rule.lhs);
+        if (universe.insert(rule.lhs).second) {
+            universe_order.push_back(rule.lhs);
+        }
+        for (const string &symbol : rule.rhs) {
+            if (universe.insert(symbol).second) {
+                universe_order.push_back(symbol);
+            }
+        }
+    }
+
+    for (const string &id : universe_order) {
+        if (grammar.non_terms.count(id) == 0) {
+            grammar.terms.insert(id);
+            grammar.term_order.push_back(id);
+        } else {
+            grammar.non_term_order.push_back(id);
+        }
+    }
+    grammar.rules = std::move(rules);
+    return grammar;
+}
+
 } // namespace analysis
@@ -0,0 +1,94 @@
+#include "budget.h"
+#include <chrono>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace {
+
+thread_local budget::RunState *current_run = nullptr;
+
+auto elapsed_ms(const budget::RunState &state) -> double {
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - state.start;
+    return elapsed.count();
+}
+
+[[noreturn]] auto exceeded(const budget::RunState &state,
+                           const std::string &limit,
+                           const char *step, size_t done, size_t total,
+                           double elapsed) -> void {
+    std::ostringstream report;
+    report << limit << " exceeded at " << step << " " << done;
+    if (total > 0) {
+        report << " of " << total;
+    }
+    report << " (" << state.rules << " rules, " << state.bytes << " bytes, "
+           << elapsed << " ms)";
+    throw BudgetExceeded(report.str());
+}
+
+} // namespace
+
+namespace budget {
+
+auto current() -> RunState * { return current_run; }
+
+Scope::Scope(const Budget &budget) : previous(current_run) {
+    state.budget = budget;
+    state.start = std::chrono::steady_clock::now();
+    current_run = budget.limited() ? &state : nullptr;
+}
+
+Scope::~Scope() { current_run = previous; }
+
+Join::Join(RunState *state) : previous(current_run) { current_run = state; }
+
+Join::~Join() { current_run = previous; }
+
+auto check(const char *step, size_t done, size_t total) -> void {
+    RunState *state = current_run;
+    if (state == nullptr) {
+        return;
+    }
+    const Budget &budget = state->budget;
+    if (budget.max_rules > 0 && state->rules > budget.max_rules) {
+        exceeded(*state,
+                 "rule budget of " + std::to_string(budget.max_rules), step,
+                 done, total, elapsed_ms(*state));
+    }
+    if (budget.max_bytes > 0 && state->bytes > budget.max_bytes) {
+        exceeded(*state,
+                 "memory budget of " + std::to_string(budget.max_bytes) +
+                     " bytes",
+                 step, done, total, elapsed_ms(*state));
+    }
+    if (budget.max_ms > 0) {
+        double elapsed = elapsed_ms(*state);
+        if (elapsed > budget.max_ms) {
+            std::ostringstream limit;
+            limit << "time budget of " << budget.max_ms << " ms";
+            exceeded(*state, limit.str(), step, done, total, elapsed);
+        }
+    }
+}
+
+auto poll(const char *step, size_t done, size_t total) -> void {
+    thread_local size_t calls = 0;
+    if (current_run != nullptr && ++calls % POLL_INTERVAL == 0) {
+        check(step, done, total);
+    }
+}
+
+auto charge(size_t rules, size_t bytes, const char *step, size_t done,
+            size_t total) -> void {
+    RunState *state = current_run;
+    if (state == nullptr) {
+        return;
+    }
+    state->rules += rules;
+    state->bytes += bytes;
+    check(step, done, total);
+}
+
+} // namespace budget
@@ -0,0 +1,324 @@
+#include "earley.h"
+#include "analysis.h"
+#include "ll1.h"
+#include "symbols.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const size_t INITIAL_SLOTS = 64;
+
+auto item_key(uint32_t pos, uint32_t origin) -> uint64_t {
+    return (static_cast<uint64_t>(pos) << 32) | origin;
+}
+
+auto slot_of(uint64_t key, size_t mask) -> size_t {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+} // namespace
+
+EarleyRecognizer::EarleyRecognizer(const EarleyGrammar &grammar)
+    : grammar(grammar), slot_key(INITIAL_SLOTS),
+      slot_stamp(INITIAL_SLOTS, 0) {}
+
+auto EarleyRecognizer::begin_set() -> void {
+    stamp++;
+    if (stamp == 0) { // wrapped: old stamps could look current
+        std::fill(slot_stamp.begin(), slot_stamp.end(), 0);
+        stamp = 1;
+    }
+    slots_used = 0;
+}
+
+auto EarleyRecognizer::add(uint32_t pos, uint32_t origin) -> void {
+    if (2 * (slots_used + 1) > slot_key.size()) {
+        grow_index();
+    }
+    uint64_t key = item_key(pos, origin);
+    size_t mask = slot_key.size() - 1;
+    for (size_t slot = slot_of(key, mask);; slot = (slot + 1) & mask) {
+        if (slot_stamp[slot] != stamp) {
+            slot_stamp[slot] = stamp;
+            slot_key[slot] = key;
+            slots_used++;
+            item_pos.push_back(pos);
+            item_origin.push_back(origin);
+            return;
+        }
+        if (slot_key[slot] == key) {
+            return;
+        }
+    }
+}
+
+// Doubles the index and re-inserts the items of the set being built
+auto EarleyRecognizer::grow_index() -> void {
+    size_t size = slot_key.size() * 2;
+    slot_key.assign(size, 0);
+    slot_stamp.assign(size, 0);
+    stamp = 1;
+
+    size_t mask = size - 1;
+    for (size_t k = set_start.back(); k < item_pos.size(); k++) {
+        uint64_t key = item_key(item_pos[k], item_origin[k]);
+        size_t slot = slot_of(key, mask);
+        while (slot_stamp[slot] == stamp) {
+            slot = (slot + 1) & mask;
+        }
+        slot_stamp[slot] = stamp;
+        slot_key[slot] = key;
+    }
+}
+
+auto EarleyRecognizer::find_leo(uint32_t set, int symbol) const
+    -> const LeoEntry * {
+    for (const LeoEntry &entry : leo[set]) {
+        if (entry.symbol == symbol) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+// The only item of set waiting on symbol, if symbol is also the last thing it
+// waits for; -1 otherwise. Acceptance looks for a completed start item from
+// set 0, as if an item S' -> . S were there, so that implicit item waits on
+// the start symbol too and no chain may jump over it.
+auto EarleyRecognizer::unique_penultimate(uint32_t set, int symbol) const
+    -> int64_t {
+    if (set == 0 && symbol == grammar.grammar.start()) {
+        return -1;
+    }
+    int64_t found = -1;
+    for (size_t k = set_start[set]; k < set_start[set + 1]; k++) {
+        if (grammar.next_symbol[item_pos[k]] != symbol) {
+            continue;
+        }
+        if (found != -1) {
+            return -1;
+        }
+        found = static_cast<int64_t>(k);
+    }
+    if (found == -1 || grammar.next_symbol[item_pos[found] + 1] != -1) {
+        return -1;
+    }
+    return found;
+}
+
+// Leo's deterministic reduction path: completing symbol from set would only
+// walk a chain of items that each have one way forward, so jump to the
+// topmost completed item of the chain. The chain is followed iteratively and
+// memoised per (set, symbol) on the way back.
+auto EarleyRecognizer::leo_item(uint32_t set, int symbol) -> int64_t {
+    std::vector<std::pair<uint32_t, int>> chain;
+    std::vector<int64_t> completed;
+    int64_t top = -1;
+    while (true) {
+        const LeoEntry *memo = find_leo(set, symbol);
+        if (memo != nullptr) {
+            top = memo->item;
+            break;
+        }
+        int64_t k = unique_penultimate(set, symbol);
+        if (k == -1) {
+            leo[set].push_back(LeoEntry{symbol, -1});
+            break;
+        }
+        uint32_t pos = item_pos[k];
+        uint32_t origin = item_origin[k];
+        chain.emplace_back(set, symbol);
+        completed.push_back(static_cast<int64_t>(item_key(pos + 1, origin)));
+        if (origin >= set) {
+            break;
+        }
+        set = origin;
+        symbol = grammar.lhs_of[pos];
+    }
+
+    for (size_t i = chain.size(); i-- > 0;) {
+        top = top >= 0 ? top : completed[i];
+        leo[chain[i].first].push_back(LeoEntry{chain[i].second, top});
+    }
+    return top;
+}
+
+auto EarleyRecognizer::recognize(const std::vector<int> &tokens) -> bool {
+    const InternedGrammar &interned = grammar.grammar;
+    for (int token : tokens) {
+        if (token < 0 || token >= interned.num_terms) {
+            return false;
+        }
+    }
+
+    const size_t n = tokens.size();
+    item_pos.clear();
+    item_origin.clear();
+    set_start.assign(1, 0);
+    if (leo.size() < n + 1) {
+        leo.resize(n + 1);
+    }
+    for (size_t i = 0; i <= n; i++) {
+        leo[i].clear();
+    }
+
+    begin_set();
+    for (int rule : interned.rules_of[interned.start() - interned.num_terms]) {
+        add(static_cast<uint32_t>(grammar.rule_start[rule]), 0);
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> scanned;
+    for (size_t i = 0; i <= n; i++) {
+        const uint32_t current = static_cast<uint32_t>(i);
+        const int token = i < n ? tokens[i] : -1;
+        scanned.clear();
+
+        // The set grows while it is processed
+        for (size_t k = set_start[i]; k < item_pos.size(); k++) {
+            const uint32_t pos = item_pos[k];
+            const uint32_t origin = item_origin[k];
+            const int symbol = grammar.next_symbol[pos];
+
+            if (symbol == -1) {
+                // Completer. Empty completions (origin == current) were
+                // already advanced over by the predictor (Aycock-Horspool).
+                if (origin == current) {
+                    continue;
+                }
+                const int lhs = grammar.lhs_of[pos];
+                int64_t top = leo_item(origin, lhs);
+                if (top >= 0) {
+                    add(static_cast<uint32_t>(top >> 32),
+                        static_cast<uint32_t>(top & 0xFFFFFFFF));
+                    continue;
+                }
+                for (size_t w = set_start[origin]; w < set_start[origin + 1];
+                     w++) {
+                    if (grammar.next_symbol[item_pos[w]] == lhs) {
+                        add(item_pos[w] + 1, item_origin[w]);
+                    }
+                }
+            } else if (interned.is_term(symbol)) {
+                // Scanner
+                if (symbol == token) {
+                    scanned.emplace_back(pos + 1, origin);
+                }
+            } else {
+                // Predictor, stepping over nullable symbols right away
+                const int non_term = symbol - interned.num_terms;
+                for (int rule : interned.rules_of[non_term]) {
+                    add(static_cast<uint32_t>(grammar.rule_start[rule]),
+                        current);
+                }
+                if (grammar.nullable[symbol] != 0) {
+                    add(pos + 1, origin);
+                }
+            }
+        }
+
+        set_start.push_back(item_pos.size());
+        if (i == n) {
+            break;
+        }
+        if (scanned.empty()) {
+            return false;
+        }
+        begin_set();
+        for (const auto &item : scanned) {
+            add(item.first, item.second);
+        }
+    }
+
+    for (size_t k = set_start[n]; k < set_start[n + 1]; k++) {
+        uint32_t pos = item_pos[k];
+        if (item_origin[k] == 0 && grammar.next_symbol[pos] == -1 &&
+            grammar.lhs_of[pos] == interned.start()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace earley {
+
+auto build_grammar(const Grammar &grammar) -> EarleyGrammar {
+    EarleyGrammar earley;
+    earley.grammar = analysis::intern_grammar(grammar);
+    const InternedGrammar &interned = earley.grammar;
+
+    for (size_t r = 0; r < interned.rule_rhs.size(); r++) {
+        earley.rule_start.push_back(
+            static_cast<int>(earley.next_symbol.size()));
+        for (int symbol : interned.rule_rhs[r]) {
+            earley.next_symbol.push_back(symbol);
+            earley.lhs_of.push_back(interned.rule_lhs[r]);
+        }
+        earley.next_symbol.push_back(-1);
+        earley.lhs_of.push_back(interned.rule_lhs[r]);
+    }
+
+    earley.nullable.assign(interned.num_symbols(), 0);
+    for (const std::string &non_term : analysis::calc_nullable(grammar)) {
+        earley.nullable[interned.ids.at(non_term)] = 1;
+    }
+    return earley;
+}
+
+auto recognize_all(const EarleyGrammar &grammar,
+                   const std::vector<std::vector<int>> &sentences)
+    -> std::vector<char> {
+    std::vector<char> accepted(sentences.size(), 0);
+
+    // A few chunks per thread balance uneven sentence lengths while keeping
+    // one recognizer's scratch space per chunk
+    size_t chunks = std::min(sentences.size(), util::worker_threads() * 8);
+    util::parallel_for(chunks, [&](size_t chunk) {
+        EarleyRecognizer recognizer(grammar);
+        for (size_t i = chunk; i < sentences.size(); i += chunks) {
+            accepted[i] = recognizer.recognize(sentences[i]) ? 1 : 0;
+        }
+    });
+    return accepted;
+}
+
+auto print_general_parse(const Grammar &grammar, const std::string &path,
+                         std::ostream &out) -> void {
+    std::ifstream in(path);
+    if (!in) {
+        out << "Error: cannot read sentences from " << path;
+        return;
+    }
+    EarleyGrammar earley = build_grammar(grammar);
+    auto sentences = ll1::read_sentences(in, earley.grammar);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> accepted = recognize_all(earley, sentences);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    for (char result : accepted) {
+        out << (result != 0 ? "ACCEPT\n" : "REJECT\n");
+    }
+
+    size_t tokens = 0;
+    for (const auto &sentence : sentences) {
+        tokens += sentence.size();
+    }
+    double seconds = elapsed.count() / 1000;
+    std::cerr << "Parsed " << sentences.size() << " sentences in "
+              << elapsed.count() << " ms (" << tokens << " tokens, "
+              << static_cast<size_t>(seconds > 0 ? tokens / seconds : 0)
+              << " tokens/s, "
+              << util::worker_threads() << " threads)\n";
+}
+
+} // namespace earley
@@ -0,0 +1,230 @@
+#include "generator.h"
+#include "symbols.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t BLOCK_SENTENCES = 4096;
+
+auto saturating_add(size_t a, size_t b) -> size_t {
+    return a > DerivationBounds::UNBOUNDED - b ? DerivationBounds::UNBOUNDED
+                                               : a + b;
+}
+
+// splitmix64, to spread (seed, block) over the RNG's seed space
+auto mix_seed(uint64_t value) -> uint64_t {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+struct Pending {
+    int symbol;
+    size_t depth;
+};
+
+class SentenceWriter {
+  public:
+    SentenceWriter(const InternedGrammar &grammar,
+                   const HeightBoundedLengths &lengths, size_t max_length,
+                   size_t max_depth)
+        : grammar(grammar), lengths(lengths), max_length(max_length),
+          max_depth(max_depth) {}
+
+    // Appends one sentence and a newline. Every pending symbol reserves the
+    // fewest terminals it can derive within the height left to it, and a
+    // rule is only chosen when it fits what the others leave. The symbol's
+    // own reservation is always met by one of its rules, so as long as the
+    // start symbol's fits max_length (checked by the caller), a rule is
+    // always found.
+    auto write(std::mt19937_64 &rng, std::string &text) -> void {
+        size_t emitted = 0;
+        size_t reserved = lengths.at(grammar.start(), max_depth);
+        bool first = true;
+
+        stack.clear();
+        stack.push_back(Pending{grammar.start(), 0});
+        while (!stack.empty()) {
+            Pending top = stack.back();
+            stack.pop_back();
+            if (grammar.is_term(top.symbol)) {
+                text += first ? "" : " ";
+                text += grammar.names[top.symbol];
+                first = false;
+                emitted++;
+                reserved--;
+                continue;
+            }
+
+            // A nonterminal's reservation is finite, so its height is >= 1
+            size_t height = max_depth - top.depth;
+            reserved -= lengths.at(top.symbol, height);
+            size_t room = max_length - emitted - reserved;
+
+            // Reservoir-sample one rule that fits
+            int chosen = grammar.rules_of[top.symbol - grammar.num_terms][0];
+            size_t chosen_length = 0;
+            size_t fitting = 0;
+            for (int rule : grammar.rules_of[top.symbol - grammar.num_terms]) {
+                size_t length = 0;
+                for (int symbol : grammar.rule_rhs[rule]) {
+                    length = saturating_add(length,
+                                            lengths.at(symbol, height - 1));
+                }
+                if (length <= room && rng() % ++fitting == 0) {
+                    chosen = rule;
+                    chosen_length = length;
+                }
+            }
+
+            reserved += chosen_length;
+            const std::vector<int> &rhs = grammar.rule_rhs[chosen];
+            for (size_t i = rhs.size(); i-- > 0;) {
+                stack.push_back(Pending{rhs[i], top.depth + 1});
+            }
+        }
+        text += '\n';
+    }
+
+  private:
+    const InternedGrammar &grammar;
+    const HeightBoundedLengths &lengths;
+    size_t max_length;
+    size_t max_depth;
+    std::vector<Pending> stack;
+};
+
+} // namespace
+
+namespace generator {
+
+auto calc_derivation_bounds(const InternedGrammar &grammar)
+    -> DerivationBounds {
+    const size_t unbounded = DerivationBounds::UNBOUNDED;
+    DerivationBounds bounds;
+    bounds.symbol_length.assign(grammar.num_symbols(), unbounded);
+    bounds.symbol_height.assign(grammar.num_symbols(), unbounded);
+    bounds.rule_length.assign(grammar.rule_rhs.size(), unbounded);
+    bounds.rule_height.assign(grammar.rule_rhs.size(), unbounded);
+    for (int term = 0; term < grammar.num_terms; term++) {
+        bounds.symbol_length[term] = 1;
+        bounds.symbol_height[term] = 0;
+    }
+
+    // Main Loop: lower bounds only ever decrease
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t r = 0; r < grammar.rule_rhs.size(); r++) {
+            size_t length = 0;
+            size_t height = 0;
+            for (int symbol : grammar.rule_rhs[r]) {
+                length = saturating_add(length, bounds.symbol_length[symbol]);
+                height = std::max(height, bounds.symbol_height[symbol]);
+            }
+            height = saturating_add(height, 1);
+            bounds.rule_length[r] = length;
+            bounds.rule_height[r] = height;
+
+            int lhs = grammar.rule_lhs[r];
+            if (length < bounds.symbol_length[lhs]) {
+                bounds.symbol_length[lhs] = length;
+                changed = true;
+            }
+            if (height < bounds.symbol_height[lhs]) {
+                bounds.symbol_height[lhs] = height;
+                changed = true;
+            }
+        }
+    }
+
+    return bounds;
+}
+
+auto calc_height_bounded_lengths(const InternedGrammar &grammar,
+                                 size_t max_height) -> HeightBoundedLengths {
+    const size_t unbounded = DerivationBounds::UNBOUNDED;
+    HeightBoundedLengths lengths;
+    std::vector<size_t> row(grammar.num_symbols(), unbounded);
+    for (int term = 0; term < grammar.num_terms; term++) {
+        row[term] = 1;
+    }
+    lengths.rows.push_back(row);
+
+    // Row h from row h - 1: a rule at height h has children at most h - 1
+    // high. Values only ever decrease, so an unchanged row is final.
+    for (size_t height = 1; height <= max_height; height++) {
+        const std::vector<size_t> &below = lengths.rows.back();
+        for (size_t r = 0; r < grammar.rule_rhs.size(); r++) {
+            size_t length = 0;
+            for (int symbol : grammar.rule_rhs[r]) {
+                length = saturating_add(length, below[symbol]);
+            }
+            int lhs = grammar.rule_lhs[r];
+            row[lhs] = std::min(row[lhs], length);
+        }
+        if (row == below) {
+            break;
+        }
+        lengths.rows.push_back(row);
+    }
+    return lengths;
+}
+
+auto print_random_sentences(const Grammar &grammar,
+                            const GeneratorOptions &options, std::ostream &out)
+    -> void {
+    InternedGrammar interned = analysis::intern_grammar(grammar);
+    DerivationBounds bounds = calc_derivation_bounds(interned);
+    const size_t start = static_cast<size_t>(interned.start());
+    if (bounds.symbol_length[start] == DerivationBounds::UNBOUNDED) {
+        out << "Error: grammar derives no sentences";
+        return;
+    }
+
+    size_t max_length =
+        std::max(options.max_length, bounds.symbol_length[start]);
+    size_t max_depth = std::max(options.max_depth, bounds.symbol_height[start]);
+    HeightBoundedLengths lengths =
+        calc_height_bounded_lengths(interned, max_depth);
+    if (lengths.at(interned.start(), max_depth) > max_length) {
+        out << "Error: no sentence has at most " << max_length
+            << " terminals and a derivation at most " << max_depth
+            << " high";
+        return;
+    }
+
+    // One wave of blocks per round keeps memory bounded for huge counts
+    size_t blocks = (options.count + BLOCK_SENTENCES - 1) / BLOCK_SENTENCES;
+    size_t wave = util::worker_threads() * 4;
+    std::vector<std::string> texts(wave);
+    for (size_t first = 0; first < blocks; first += wave) {
+        size_t in_wave = std::min(wave, blocks - first);
+        util::parallel_for(in_wave, [&](size_t i) {
+            size_t block = first + i;
+            size_t sentences = std::min(
+                BLOCK_SENTENCES, options.count - block * BLOCK_SENTENCES);
+            std::mt19937_64 rng(mix_seed(options.seed ^ mix_seed(block)));
+            SentenceWriter writer(interned, lengths, max_length, max_depth);
+            std::string &text = texts[i];
+            text.clear();
+            for (size_t s = 0; s < sentences; s++) {
+                writer.write(rng, text);
+            }
+        });
+        for (size_t i = 0; i < in_wave; i++) {
+            out.write(texts[i].data(),
+                      static_cast<std::streamsize>(texts[i].size()));
+        }
+    }
+}
+
+} // namespace generator
@@ -0,0 +1,171 @@
+#include "ingest.h"
+#include "parser.h"
+#include "probes.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <iterator>
+#include <streambuf>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Lets a Parser read straight from mapped memory
+class MemoryBuffer : public std::streambuf {
+  public:
+    MemoryBuffer(const char *begin, const char *end) {
+        char *data = const_cast<char *>(begin);
+        setg(data, data, data + (end - begin));
+    }
+};
+
+auto parse_sequential(const char *begin, const char *end) -> Grammar {
+    MemoryBuffer buffer(begin, end);
+    std::istream in(&buffer);
+    Parser parser(in);
+    parser.parse_input();
+    return parser.generate_grammar();
+}
+
+// Chunk starts, then end. Every start but the first is just past a '*', so
+// at a rule boundary, and none is past the first '#'.
+auto split_points(const char *begin, const char *end, size_t chunks)
+    -> std::vector<const char *> {
+    const void *hash = memchr(begin, '#', end - begin);
+    const char *limit = hash == nullptr ? end : static_cast<const char *>(hash);
+    const size_t target = (end - begin) / chunks;
+
+    std::vector<const char *> points{begin};
+    for (size_t k = 1; k < chunks; k++) {
+        const char *from = std::max(points.back(), begin + k * target);
+        if (from >= limit) {
+            break;
+        }
+        const void *star = memchr(from, '*', limit - from);
+        if (star == nullptr) {
+            break;
+        }
+        points.push_back(static_cast<const char *>(star) + 1);
+    }
+    points.push_back(end);
+    return points;
+}
+
+// Unmaps on every way out of parse_stdin
+struct Mapping {
+    void *data;
+    size_t size;
+    ~Mapping() { munmap(data, size); }
+};
+
+} // namespace
+
+namespace ingest {
+
+auto parse_chunked(const char *begin, const char *end, size_t min_chunk_bytes)
+    -> Grammar {
+    const size_t size = end - begin;
+    size_t chunks =
+        std::min(util::worker_threads() * 4, size / min_chunk_bytes);
+    std::vector<const char *> points =
+        split_points(begin, end, std::max<size_t>(chunks, 1));
+    const size_t count = points.size() - 1;
+    if (count == 1) {
+        return parse_sequential(begin, end);
+    }
+
+    std::vector<ParsedChunk> parsed(count);
+    std::vector<size_t> newlines(count, 0);
+    std::vector<int> error_line(count, 0);
+    std::vector<char> failed(count, 0);
+    std::vector<char> ebnf(count, 0);
+    util::parallel_for(count, [&](size_t i) {
+        newlines[i] = std::count(points[i], points[i + 1], '\n');
+        MemoryBuffer buffer(points[i], points[i + 1]);
+        std::istream in(&buffer);
+        Parser parser(in);
+        try {
+            parser.parse_chunk(i == 0, i + 1 == count);
+        } catch (const SyntaxError &error) {
+            failed[i] = 1;
+            error_line[i] = error.line;
+        }
+        ebnf[i] = parser.uses_ebnf() ? 1 : 0;
+        parsed[i] = parser.take_chunk();
+    });
+
+    if (std::find(ebnf.begin(), ebnf.end(), 1) != ebnf.end()) {
+        return parse_sequential(begin, end);
+    }
+    size_t lines_before = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (failed[i] != 0) {
+            throw SyntaxError(static_cast<int>(lines_before) + error_line[i]);
+        }
+        lines_before += newlines[i];
+    }
+
+    // Chunk orders concatenated, keeping each symbol's first appearance
+    Grammar grammar;
+    std::unordered_set<std::string> universe;
+    std::vector<std::string> universe_order;
+    size_t num_rules = 0;
+    for (const ParsedChunk &chunk : parsed) {
+        num_rules += chunk.rules.size();
+    }
+    grammar.rules.reserve(num_rules);
+    for (ParsedChunk &chunk : parsed) {
+        for (std::string &id : chunk.universe_order) {
+            if (universe.insert(id).second) {
+                universe_order.push_back(std::move(id));
+            }
+        }
+        grammar.non_terms.insert(chunk.non_terms.begin(),
+                                 chunk.non_terms.end());
+        std::move(chunk.rules.begin(), chunk.rules.end(),
+                  std::back_inserter(grammar.rules));
+    }
+
+    for (std::string &id : universe_order) {
+        if (grammar.non_terms.count(id) == 0) {
+            grammar.terms.insert(id);
+            grammar.term_order.push_back(std::move(id));
+        } else {
+            grammar.non_term_order.push_back(std::move(id));
+        }
+    }
+    PROBE2(ingest_done, count, grammar.rules.size());
+    return grammar;
+}
+
+auto parse_stdin(size_t min_chunk_bytes) -> Grammar {
+    struct stat info;
+    if (fstat(STDIN_FILENO, &info) == 0 && S_ISREG(info.st_mode) &&
+        info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        void *data =
+            mmap(nullptr, size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+        if (data != MAP_FAILED) {
+            Mapping mapping{data, size};
+            madvise(data, size, MADV_SEQUENTIAL);
+            const char *text = static_cast<const char *>(data);
+            return parse_chunked(text, text + size, min_chunk_bytes);
+        }
+    }
+
+    std::string text((std::istreambuf_iterator<char>(std::cin)),
+                     std::istreambuf_iterator<char>());
+    return parse_chunked(text.data(), text.data() + text.size(),
+                         min_chunk_bytes);
+}
+
+} // namespace ingest
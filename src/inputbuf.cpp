@@ -18,7 +18,7 @@ bool InputBuffer::EndOfInput()
     if (!input_buffer.empty())
         return false;
     else
-        return cin.eof();
+        return in->eof();
 }
 
 char InputBuffer::UngetChar(char c)
@@ -34,7 +34,7 @@ void InputBuffer::GetChar(char& c)
         c = input_buffer.back();
         input_buffer.pop_back();
     } else {
-        cin.get(c);
+        in->get(c);
     }
 }
 
@@ -0,0 +1,374 @@
+#include "lalr.h"
+#include "analysis.h"
+#include "bitset.h"
+#include "symbols.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct KernelHasher {
+    auto operator()(const std::vector<int> &kernel) const -> size_t {
+        size_t hash = kernel.size();
+        for (int item : kernel) {
+            hash = (hash * 1000003) ^ static_cast<size_t>(item);
+        }
+        return hash;
+    }
+};
+
+// Digraph algorithm (DeRemer & Pennello): sets[x] becomes the union of
+// sets[y] over every y reachable from x through relation. Members of a
+// cycle end up with identical sets, computed once.
+auto digraph(const std::vector<std::vector<int>> &relation,
+             std::vector<Bitset> &sets) -> void {
+    const int done = INT_MAX;
+    const int num_nodes = static_cast<int>(relation.size());
+    std::vector<int> depth(num_nodes, 0);
+    std::vector<int> stack;
+
+    // Explicit call stack of (node, next edge, depth on entry)
+    struct Frame {
+        int node;
+        size_t edge;
+        int entry_depth;
+    };
+    std::vector<Frame> calls;
+
+    for (int root = 0; root < num_nodes; root++) {
+        if (depth[root] != 0) {
+            continue;
+        }
+        stack.push_back(root);
+        depth[root] = static_cast<int>(stack.size());
+        calls.push_back(Frame{root, 0, depth[root]});
+
+        while (!calls.empty()) {
+            Frame &frame = calls.back();
+            int node = frame.node;
+            if (frame.edge < relation[node].size()) {
+                int next = relation[node][frame.edge++];
+                if (depth[next] == 0) {
+                    stack.push_back(next);
+                    depth[next] = static_cast<int>(stack.size());
+                    calls.push_back(Frame{next, 0, depth[next]});
+                    continue;
+                }
+                depth[node] = std::min(depth[node], depth[next]);
+                sets[node].merge(sets[next]);
+                continue;
+            }
+
+            int entry_depth = frame.entry_depth;
+            calls.pop_back();
+            if (depth[node] == entry_depth) {
+                int member = 0;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    depth[member] = done;
+                    if (member != node) {
+                        sets[member] = sets[node];
+                    }
+                } while (member != node);
+            }
+            if (!calls.empty()) {
+                int parent = calls.back().node;
+                depth[parent] = std::min(depth[parent], depth[node]);
+                sets[parent].merge(sets[node]);
+            }
+        }
+    }
+}
+
+auto rule_to_string(const LalrAutomaton &automaton, int rule) -> std::string {
+    const InternedGrammar &grammar = automaton.grammar;
+    if (rule == automaton.augmented_rule) {
+        return "accept";
+    }
+    std::vector<std::string> rhs;
+    for (int symbol : grammar.rule_rhs[rule]) {
+        rhs.push_back(grammar.names[symbol]);
+    }
+    return grammar.names[grammar.rule_lhs[rule]] + " -> " +
+           util::join_vec_string(rhs, " ") + " #";
+}
+
+} // namespace
+
+auto LalrAutomaton::goto_state(int state, int symbol) const -> int {
+    const auto &edges = transitions[state];
+    auto found = std::lower_bound(
+        edges.begin(), edges.end(), std::make_pair(symbol, INT_MIN));
+    if (found == edges.end() || found->first != symbol) {
+        return -1;
+    }
+    return found->second;
+}
+
+namespace analysis {
+
+auto print_lalr_report(const Grammar &grammar, std::ostream &out) -> void {
+    auto automaton = build_lalr(grammar);
+    auto conflicts = find_lalr_conflicts(automaton);
+
+    size_t shift_reduce = 0;
+    size_t reduce_reduce = 0;
+    for (const LalrConflict &conflict : conflicts) {
+        shift_reduce += conflict.shift ? 1 : 0;
+        reduce_reduce += conflict.rules.size() > 1 ? 1 : 0;
+    }
+
+    out << "States = " << automaton.kernels.size() << "\n";
+    out << "Shift/reduce conflicts = " << shift_reduce << "\n";
+    out << "Reduce/reduce conflicts = " << reduce_reduce;
+    for (const LalrConflict &conflict : conflicts) {
+        std::vector<std::string> actions;
+        if (conflict.shift) {
+            actions.emplace_back("shift");
+        }
+        for (int rule : conflict.rules) {
+            actions.push_back(rule_to_string(automaton, rule));
+        }
+        const std::string &terminal =
+            conflict.terminal == automaton.end_marker()
+                ? "$"
+                : automaton.grammar.names[conflict.terminal];
+        out << "\nCONFLICT(" << conflict.state << ", " << terminal << ") = { "
+            << util::join_vec_string(actions, ", ") << " }";
+    }
+}
+
+auto build_lalr(const Grammar &grammar) -> LalrAutomaton {
+    LalrAutomaton automaton;
+    automaton.grammar = intern_grammar(grammar);
+    InternedGrammar &interned = automaton.grammar;
+    const int num_terms = interned.num_terms;
+
+    // Augment with S' -> S
+    automaton.augmented_rule = static_cast<int>(interned.rule_lhs.size());
+    interned.rule_lhs.push_back(interned.num_symbols());
+    interned.rule_rhs.push_back(std::vector<int>{interned.start()});
+
+    int num_items = 0;
+    for (size_t r = 0; r < interned.rule_rhs.size(); r++) {
+        automaton.item_base.push_back(num_items);
+        for (size_t dot = 0; dot <= interned.rule_rhs[r].size(); dot++) {
+            automaton.item_rule.push_back(static_cast<int>(r));
+        }
+        num_items += static_cast<int>(interned.rule_rhs[r].size()) + 1;
+    }
+
+    //
+    // LR(0) automaton: states are identified by their sorted kernel
+    //
+    std::unordered_map<std::vector<int>, int, KernelHasher> state_of;
+    automaton.kernels.push_back(
+        {automaton.item_base[automaton.augmented_rule]});
+    state_of.emplace(automaton.kernels[0], 0);
+
+    std::vector<int> closed_in(interned.num_non_terms(), -1);
+    std::vector<std::vector<int>> goto_kernels(interned.num_symbols());
+    std::vector<int> next_symbols;
+    for (size_t state = 0; state < automaton.kernels.size(); state++) {
+        automaton.transitions.emplace_back();
+        automaton.reductions.emplace_back();
+
+        std::vector<int> closure = automaton.kernels[state];
+        for (size_t i = 0; i < closure.size(); i++) {
+            int item = closure[i];
+            int rule = automaton.item_rule[item];
+            size_t dot = item - automaton.item_base[rule];
+            const std::vector<int> &rhs = interned.rule_rhs[rule];
+            if (dot == rhs.size()) {
+                automaton.reductions[state].push_back(rule);
+                continue;
+            }
+
+            int symbol = rhs[dot];
+            if (goto_kernels[symbol].empty()) {
+                next_symbols.push_back(symbol);
+            }
+            goto_kernels[symbol].push_back(item + 1);
+
+            int nt = symbol - num_terms;
+            if (interned.is_term(symbol) ||
+                closed_in[nt] == static_cast<int>(state)) {
+                continue;
+            }
+            closed_in[nt] = static_cast<int>(state);
+            for (int nt_rule : interned.rules_of[nt]) {
+                closure.push_back(automaton.item_base[nt_rule]);
+            }
+        }
+        std::sort(automaton.reductions[state].begin(),
+                  automaton.reductions[state].end());
+
+        std::sort(next_symbols.begin(), next_symbols.end());
+        for (int symbol : next_symbols) {
+            std::vector<int> kernel;
+            kernel.swap(goto_kernels[symbol]);
+            std::sort(kernel.begin(), kernel.end());
+
+            auto inserted = state_of.emplace(
+                kernel, static_cast<int>(automaton.kernels.size()));
+            if (inserted.second) {
+                automaton.kernels.push_back(std::move(kernel));
+            }
+            automaton.transitions[state].emplace_back(symbol,
+                                                      inserted.first->second);
+        }
+        next_symbols.clear();
+    }
+
+    //
+    // LALR(1) lookaheads (DeRemer & Pennello)
+    //
+    const int num_states = static_cast<int>(automaton.kernels.size());
+    std::vector<char> nullable(interned.num_symbols(), 0);
+    for (const std::string &non_term : calc_nullable(grammar)) {
+        nullable[interned.ids.at(non_term)] = 1;
+    }
+
+    // suffix_nullable[item]: the rhs from the dot onwards derives epsilon
+    std::vector<char> suffix_nullable(num_items, 1);
+    for (size_t r = 0; r < interned.rule_rhs.size(); r++) {
+        const std::vector<int> &rhs = interned.rule_rhs[r];
+        int base = automaton.item_base[r];
+        for (int dot = static_cast<int>(rhs.size()) - 1; dot >= 0; dot--) {
+            suffix_nullable[base + dot] =
+                suffix_nullable[base + dot + 1] && nullable[rhs[dot]];
+        }
+    }
+
+    // Number the nonterminal transitions (p, A)
+    std::vector<int> trans_from;
+    std::vector<int> trans_symbol;
+    std::vector<int> trans_to;
+    std::vector<std::vector<int>> nt_trans_index(num_states);
+    for (int state = 0; state < num_states; state++) {
+        for (const auto &edge : automaton.transitions[state]) {
+            if (interned.is_term(edge.first)) {
+                nt_trans_index[state].push_back(-1);
+                continue;
+            }
+            nt_trans_index[state].push_back(
+                static_cast<int>(trans_from.size()));
+            trans_from.push_back(state);
+            trans_symbol.push_back(edge.first);
+            trans_to.push_back(edge.second);
+        }
+    }
+    auto trans_index = [&](int state, int symbol) -> int {
+        const auto &edges = automaton.transitions[state];
+        auto found = std::lower_bound(edges.begin(), edges.end(),
+                                      std::make_pair(symbol, INT_MIN));
+        return nt_trans_index[state][found - edges.begin()];
+    };
+
+    // DR and reads, then Read = digraph(DR, reads)
+    const int num_trans = static_cast<int>(trans_from.size());
+    const size_t lookahead_bits = num_terms + 1;
+    std::vector<Bitset> follow(num_trans, Bitset(lookahead_bits));
+    std::vector<std::vector<int>> reads(num_trans);
+    for (int x = 0; x < num_trans; x++) {
+        int target = trans_to[x];
+        const auto &edges = automaton.transitions[target];
+        for (size_t e = 0; e < edges.size(); e++) {
+            if (interned.is_term(edges[e].first)) {
+                follow[x].set(edges[e].first);
+            } else if (nullable[edges[e].first]) {
+                reads[x].push_back(nt_trans_index[target][e]);
+            }
+        }
+        if (trans_from[x] == 0 && trans_symbol[x] == interned.start()) {
+            follow[x].set(automaton.end_marker());
+        }
+    }
+    digraph(reads, follow);
+
+    // includes and lookback, then Follow = digraph(Read, includes)
+    std::vector<std::vector<int>> includes(num_trans);
+    std::vector<std::vector<std::vector<int>>> lookback(num_states);
+    for (int state = 0; state < num_states; state++) {
+        lookback[state].resize(automaton.reductions[state].size());
+    }
+    for (int x = 0; x < num_trans; x++) {
+        for (int rule : interned.rules_of[trans_symbol[x] - num_terms]) {
+            const std::vector<int> &rhs = interned.rule_rhs[rule];
+            int base = automaton.item_base[rule];
+            int state = trans_from[x];
+            for (size_t dot = 0; dot < rhs.size(); dot++) {
+                if (!interned.is_term(rhs[dot]) &&
+                    suffix_nullable[base + dot + 1]) {
+                    includes[trans_index(state, rhs[dot])].push_back(x);
+                }
+                state = automaton.goto_state(state, rhs[dot]);
+            }
+
+            const auto &completed = automaton.reductions[state];
+            size_t k = std::lower_bound(completed.begin(), completed.end(),
+                                        rule) -
+                       completed.begin();
+            lookback[state][k].push_back(x);
+        }
+    }
+    digraph(includes, follow);
+
+    automaton.lookaheads.resize(num_states);
+    for (int state = 0; state < num_states; state++) {
+        for (const std::vector<int> &sources : lookback[state]) {
+            Bitset lookahead(lookahead_bits);
+            for (int x : sources) {
+                lookahead.merge(follow[x]);
+            }
+            automaton.lookaheads[state].push_back(std::move(lookahead));
+        }
+    }
+
+    return automaton;
+}
+
+auto find_lalr_conflicts(const LalrAutomaton &automaton)
+    -> std::vector<LalrConflict> {
+    const int end_marker = automaton.end_marker();
+    std::vector<LalrConflict> conflicts;
+    std::vector<std::vector<int>> reducers(end_marker + 1);
+
+    for (size_t state = 0; state < automaton.kernels.size(); state++) {
+        const auto &completed = automaton.reductions[state];
+        for (size_t k = 0; k < completed.size(); k++) {
+            if (completed[k] == automaton.augmented_rule) {
+                reducers[end_marker].push_back(completed[k]);
+                continue;
+            }
+            automaton.lookaheads[state][k].for_each(
+                [&](size_t terminal) {
+                    reducers[terminal].push_back(completed[k]);
+                });
+        }
+
+        // Report $ first, then terminals in order of appearance
+        for (int i = 0; i <= end_marker; i++) {
+            int terminal = i == 0 ? end_marker : i - 1;
+            std::vector<int> &rules = reducers[terminal];
+            bool shift = terminal != end_marker &&
+                         automaton.goto_state(state, terminal) != -1;
+            if (rules.size() > 1 || (shift && !rules.empty())) {
+                conflicts.push_back(LalrConflict{static_cast<int>(state),
+                                                 terminal, shift, rules});
+            }
+            rules.clear();
+        }
+    }
+    return conflicts;
+}
+
+} // namespace analysis
@@ -7,24 +7,29 @@
 #include <iostream>
 #include <istream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "inputbuf.h"
 #include "lexer.h"
+#include "probes.h"
 
 using namespace std;
 
 // Lexer modified for FIRST & FOLLOW project
 
-string reserved[] = {"END_OF_FILE", "ARROW", "STAR", "HASH",
-                     "ID",          "ERROR", "OR"};
+string reserved[] = {"END_OF_FILE", "ARROW",  "STAR",   "HASH",  "ID",
+                     "ERROR",       "OR",     "LPAREN", "RPAREN", "LBRAC",
+                     "RBRAC",       "LBRACE", "RBRACE", "PLUS"};
 
 void Token::Print() {
     cout << "{" << this->lexeme << " , " << reserved[(int)this->token_type]
          << " , " << this->line_no << "}\n";
 }
 
-LexicalAnalyzer::LexicalAnalyzer() {
+LexicalAnalyzer::LexicalAnalyzer() : LexicalAnalyzer(cin) {}
+
+LexicalAnalyzer::LexicalAnalyzer(istream& in) : input(in) {
     this->line_no = 1;
     tmp.lexeme = "";
     tmp.line_no = 1;
@@ -34,10 +39,14 @@ LexicalAnalyzer::LexicalAnalyzer() {
     index = 0;
 
     while (token.token_type != END_OF_FILE) {
-        tokenList.push_back(token); // push token into internal list
-        token = GetTokenMain();     // and get next token from standatd input
+        tokenList.push_back(std::move(token)); // push token into internal list
+        token = GetTokenMain(); // and get next token from standatd input
     }
     // pushes END_OF_FILE is not pushed on the token list
+    end_of_file.lexeme = "";
+    end_of_file.line_no = line_no;
+    end_of_file.token_type = END_OF_FILE;
+    PROBE2(lex_done, tokenList.size(), line_no);
 }
 
 bool LexicalAnalyzer::SkipSpace() {
@@ -86,21 +95,16 @@ Token LexicalAnalyzer::ScanId() {
 
 // GetToken() accesses tokens from the tokenList that is populated when a
 // lexer object is instantiated
-Token LexicalAnalyzer::GetToken() {
-    Token token;
+const Token &LexicalAnalyzer::GetToken() {
     if (index == tokenList.size()) { // return end of file if
-        token.lexeme = "";           // index is too large
-        token.line_no = line_no;
-        token.token_type = END_OF_FILE;
-    } else {
-        token = tokenList[index];
-        index = index + 1;
+        return end_of_file;          // index is too large
     }
-    return token;
+    index = index + 1;
+    return tokenList[index - 1];
 }
 
 // peek requires that the argument "howFar" be positive.
-Token LexicalAnalyzer::peek(int howFar) {
+const Token &LexicalAnalyzer::peek(int howFar) {
     if (howFar <= 0) { // peeking backward or in place is not allowed
         cout << "LexicalAnalyzer:peek:Error: non positive argument\n";
         exit(-1);
@@ -108,11 +112,7 @@ Token LexicalAnalyzer::peek(int howFar) {
 
     int peekIndex = index + howFar - 1;
     if (peekIndex > ((int)tokenList.size() - 1)) { // if peeking too far
-        Token token;                               // return END_OF_FILE
-        token.lexeme = "";
-        token.line_no = line_no;
-        token.token_type = END_OF_FILE;
-        return token;
+        return end_of_file;                        // return END_OF_FILE
     } else
         return tokenList[peekIndex];
 }
@@ -150,6 +150,27 @@ Token LexicalAnalyzer::GetTokenMain() {
     case '|':
         tmp.token_type = OR;
         return tmp;
+    case '(':
+        tmp.token_type = LPAREN;
+        return tmp;
+    case ')':
+        tmp.token_type = RPAREN;
+        return tmp;
+    case '[':
+        tmp.token_type = LBRAC;
+        return tmp;
+    case ']':
+        tmp.token_type = RBRAC;
+        return tmp;
+    case '{':
+        tmp.token_type = LBRACE;
+        return tmp;
+    case '}':
+        tmp.token_type = RBRACE;
+        return tmp;
+    case '+':
+        tmp.token_type = PLUS;
+        return tmp;
     default:
         if (isalpha(c)) {
             input.UngetChar(c);
@@ -0,0 +1,435 @@
+#include "ll1.h"
+#include "analysis.h"
+#include "suffix_first.h"
+#include "symbols.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct FormHasher {
+    auto operator()(const std::vector<int> &form) const -> size_t {
+        size_t hash = form.size();
+        for (int symbol : form) {
+            hash = (hash * 1000003) ^ static_cast<size_t>(symbol);
+        }
+        return hash;
+    }
+};
+
+auto rule_to_string(const InternedGrammar &grammar, int rule) -> std::string {
+    std::vector<std::string> rhs;
+    for (int symbol : grammar.rule_rhs[rule]) {
+        rhs.push_back(grammar.names[symbol]);
+    }
+    return grammar.names[grammar.rule_lhs[rule]] + " -> " +
+           util::join_vec_string(rhs, " ") + " #";
+}
+
+auto lookahead_name(const InternedGrammar &grammar, int lookahead)
+    -> std::string {
+    return lookahead == grammar.num_terms ? "$" : grammar.names[lookahead];
+}
+
+// Enum constant for a terminal, or T_END for $
+auto token_constant(const InternedGrammar &grammar, int lookahead)
+    -> std::string {
+    return lookahead == grammar.num_terms ? "T_END"
+                                          : "T_" + grammar.names[lookahead];
+}
+
+auto sentence_to_string(const InternedGrammar &grammar,
+                        const std::vector<int> &sentence) -> std::string {
+    std::vector<std::string> names;
+    for (int symbol : sentence) {
+        names.push_back(grammar.names[symbol]);
+    }
+    return util::join_vec_string(names, " ");
+}
+
+} // namespace
+
+namespace ll1 {
+
+auto build_table(const Grammar &grammar) -> LL1Table {
+    LL1Table table;
+    table.grammar = analysis::intern_grammar(grammar);
+    const InternedGrammar &interned = table.grammar;
+    table.entries.assign(interned.num_non_terms() * table.width(), -1);
+
+    auto nullable = analysis::calc_nullable(grammar);
+    auto first = analysis::calc_first(grammar);
+    auto follow = analysis::calc_follow(grammar);
+
+    const SuffixFirstTable suffixes =
+        analysis::build_suffix_first(interned, first, nullable);
+
+    // PREDICT(A -> x) = FIRST(x), plus FOLLOW(A) when x is nullable
+    std::unordered_map<size_t, std::vector<int>> clashes;
+    std::vector<int> predict;
+    for (size_t r = 0; r < grammar.rules.size(); r++) {
+        const Rule &rule = grammar.rules[r];
+        const SuffixFirst &rhs = suffixes.at(r, 0);
+        predict.assign(suffixes.first_begin(rhs), suffixes.first_end(rhs));
+        if (rhs.nullable) {
+            for (const std::string &lookahead : follow[rule.lhs]) {
+                predict.push_back(lookahead == "$"
+                                      ? interned.num_terms
+                                      : interned.ids.at(lookahead));
+            }
+            std::sort(predict.begin(), predict.end());
+            predict.erase(std::unique(predict.begin(), predict.end()),
+                          predict.end());
+        }
+
+        int lhs = interned.ids.at(rule.lhs);
+        for (int column : predict) {
+            size_t cell = (lhs - interned.num_terms) * table.width() + column;
+            int &entry = table.entries[cell];
+            if (entry == -1) {
+                entry = static_cast<int>(r);
+                continue;
+            }
+            std::vector<int> &rules = clashes[cell];
+            if (rules.empty()) {
+                rules.push_back(entry);
+            }
+            rules.push_back(static_cast<int>(r));
+        }
+    }
+
+    for (const auto &clash : clashes) {
+        int non_term =
+            static_cast<int>(clash.first / table.width()) + interned.num_terms;
+        int lookahead = static_cast<int>(clash.first % table.width());
+        table.conflicts.push_back(
+            LL1Conflict{non_term, lookahead, clash.second});
+    }
+    std::sort(table.conflicts.begin(), table.conflicts.end(),
+              [](const LL1Conflict &a, const LL1Conflict &b) {
+                  return std::make_pair(a.non_term, a.lookahead) <
+                         std::make_pair(b.non_term, b.lookahead);
+              });
+    return table;
+}
+
+auto parse(const LL1Table &table, const std::vector<int> &tokens,
+           std::vector<int> &stack) -> bool {
+    const InternedGrammar &grammar = table.grammar;
+    const int end = grammar.num_terms;
+    size_t pos = 0;
+
+    stack.clear();
+    stack.push_back(grammar.start());
+    while (!stack.empty()) {
+        int top = stack.back();
+        stack.pop_back();
+        int lookahead = pos < tokens.size() ? tokens[pos] : end;
+        if (lookahead < 0 || lookahead > end) {
+            return false;
+        }
+
+        if (grammar.is_term(top)) {
+            if (top != lookahead) {
+                return false;
+            }
+            pos++;
+            continue;
+        }
+
+        int rule = table.entry(top, lookahead);
+        if (rule == -1) {
+            return false;
+        }
+        const std::vector<int> &rhs = grammar.rule_rhs[rule];
+        stack.insert(stack.end(), rhs.rbegin(), rhs.rend());
+    }
+    return pos == tokens.size();
+}
+
+auto read_sentences(std::istream &in, const InternedGrammar &grammar)
+    -> std::vector<std::vector<int>> {
+    std::vector<std::vector<int>> sentences;
+    std::string line;
+    std::string word;
+    while (std::getline(in, line)) {
+        std::istringstream words(line);
+        std::vector<int> tokens;
+        while (words >> word) {
+            auto found = grammar.ids.find(word);
+            bool known = found != grammar.ids.end() &&
+                         grammar.is_term(found->second);
+            tokens.push_back(known ? found->second : -1);
+        }
+        sentences.push_back(std::move(tokens));
+    }
+    return sentences;
+}
+
+auto print_generated_parser(const Grammar &grammar, std::ostream &out)
+    -> void {
+    LL1Table table = build_table(grammar);
+    if (table.conflicts.empty()) {
+        generate_parser(table, out);
+        return;
+    }
+
+    const InternedGrammar &interned = table.grammar;
+    out << "Error: grammar is not LL(1)";
+    for (const LL1Conflict &conflict : table.conflicts) {
+        std::vector<std::string> rules;
+        for (int rule : conflict.rules) {
+            rules.push_back(rule_to_string(interned, rule));
+        }
+        out << "\nCONFLICT(" << interned.names[conflict.non_term] << ", "
+            << lookahead_name(interned, conflict.lookahead) << ") = { "
+            << util::join_vec_string(rules, ", ") << " }";
+    }
+}
+
+auto generate_parser(const LL1Table &table, std::ostream &out) -> void {
+    const InternedGrammar &grammar = table.grammar;
+    const int end = grammar.num_terms;
+
+    out << "// Recursive-descent parser generated by `a.out 11` from an LL(1)\n"
+        << "// grammar. Tokens are the ids below; parse() takes an array of\n"
+        << "// them and neither allocates nor consults a table.\n"
+        << "#include <cstddef>\n"
+        << "#include <cstring>\n\n"
+        << "namespace generated_parser {\n\n"
+        << "enum Token : int {\n"
+        << "    END_OF_INPUT = 0,\n";
+    for (int term = 0; term < grammar.num_terms; term++) {
+        out << "    " << token_constant(grammar, term) << " = " << term + 1
+            << ",\n";
+    }
+    out << "};\n\n"
+        << "const int num_tokens = " << grammar.num_terms + 1 << ";\n"
+        << "const char *const token_names[] = {\"$\"";
+    for (int term = 0; term < grammar.num_terms; term++) {
+        out << ", \"" << grammar.names[term] << "\"";
+    }
+    out << "};\n\n"
+        << "// Maps a terminal name to its token id, or -1\n"
+        << "inline int token_id(const char *name) {\n"
+        << "    for (int id = 1; id < num_tokens; id++) {\n"
+        << "        if (std::strcmp(token_names[id], name) == 0) {\n"
+        << "            return id;\n"
+        << "        }\n"
+        << "    }\n"
+        << "    return -1;\n"
+        << "}\n\n"
+        << "struct Input {\n"
+        << "    const int *tokens;\n"
+        << "    std::size_t size;\n"
+        << "    std::size_t pos;\n\n"
+        << "    int peek() const { return pos < size ? tokens[pos] : "
+           "END_OF_INPUT; }\n"
+        << "};\n\n";
+
+    for (int nt = grammar.num_terms; nt < grammar.num_symbols(); nt++) {
+        out << "inline bool parse_" << grammar.names[nt] << "(Input &in);\n";
+    }
+
+    for (int nt = grammar.num_terms; nt < grammar.num_symbols(); nt++) {
+        out << "\ninline bool parse_" << grammar.names[nt]
+            << "(Input &in) {\n"
+            << "    switch (in.peek()) {\n";
+        for (int rule : grammar.rules_of[nt - grammar.num_terms]) {
+            // Case labels: every lookahead whose table entry is this rule
+            bool predicted = false;
+            for (int lookahead = 0; lookahead <= end; lookahead++) {
+                if (table.entry(nt, lookahead) != rule) {
+                    continue;
+                }
+                predicted = true;
+                out << "    case "
+                    << (lookahead == end ? "END_OF_INPUT"
+                                         : token_constant(grammar, lookahead))
+                    << ":\n";
+            }
+            if (!predicted) {
+                continue;
+            }
+
+            out << "        // " << rule_to_string(grammar, rule) << "\n";
+            const std::vector<int> &rhs = grammar.rule_rhs[rule];
+            for (size_t i = 0; i < rhs.size(); i++) {
+                const std::string &name = grammar.names[rhs[i]];
+                if (!grammar.is_term(rhs[i])) {
+                    if (i + 1 == rhs.size()) {
+                        out << "        return parse_" << name << "(in);\n";
+                    } else {
+                        out << "        if (!parse_" << name
+                            << "(in)) {\n            return false;\n"
+                            << "        }\n";
+                    }
+                    continue;
+                }
+                // A leading terminal is the only lookahead that selects the
+                // rule, so the switch already matched it
+                if (i > 0) {
+                    out << "        if (in.peek() != "
+                        << token_constant(grammar, rhs[i])
+                        << ") {\n            return false;\n        }\n";
+                }
+                out << "        in.pos++;\n";
+            }
+            if (rhs.empty() || grammar.is_term(rhs.back())) {
+                out << "        return true;\n";
+            }
+        }
+        out << "    default:\n"
+            << "        return false;\n"
+            << "    }\n"
+            << "}\n";
+    }
+
+    out << "\ninline bool parse(const int *tokens, std::size_t size) {\n"
+        << "    Input in{tokens, size, 0};\n"
+        << "    return parse_" << grammar.names[grammar.start()]
+        << "(in) && in.pos == size;\n"
+        << "}\n\n"
+        << "} // namespace generated_parser\n\n"
+        << "#ifdef GENERATED_PARSER_MAIN\n"
+        << "#include <chrono>\n"
+        << "#include <iostream>\n"
+        << "#include <sstream>\n"
+        << "#include <string>\n"
+        << "#include <vector>\n\n"
+        << "// Reads one sentence per line and prints ACCEPT or REJECT for "
+           "each\n"
+        << "int main() {\n"
+        << "    std::vector<std::vector<int>> sentences;\n"
+        << "    std::string line;\n"
+        << "    std::string word;\n"
+        << "    while (std::getline(std::cin, line)) {\n"
+        << "        std::istringstream words(line);\n"
+        << "        std::vector<int> tokens;\n"
+        << "        while (words >> word) {\n"
+        << "            tokens.push_back(generated_parser::token_id("
+           "word.c_str()));\n"
+        << "        }\n"
+        << "        sentences.push_back(tokens);\n"
+        << "    }\n\n"
+        << "    std::vector<char> accepted(sentences.size());\n"
+        << "    auto start = std::chrono::steady_clock::now();\n"
+        << "    for (std::size_t i = 0; i < sentences.size(); i++) {\n"
+        << "        accepted[i] = generated_parser::parse("
+           "sentences[i].data(),\n"
+        << "                                              "
+           "sentences[i].size());\n"
+        << "    }\n"
+        << "    std::chrono::duration<double, std::milli> elapsed =\n"
+        << "        std::chrono::steady_clock::now() - start;\n\n"
+        << "    for (char result : accepted) {\n"
+        << "        std::cout << (result ? \"ACCEPT\\n\" : \"REJECT\\n\");\n"
+        << "    }\n"
+        << "    std::cerr << \"Parsed \" << sentences.size() << "
+           "\" sentences in \"\n"
+        << "              << elapsed.count() << \" ms\\n\";\n"
+        << "    return 0;\n"
+        << "}\n"
+        << "#endif\n";
+}
+
+auto print_table_parse(const Grammar &grammar, const std::string &path,
+                       std::ostream &out) -> void {
+    LL1Table table = build_table(grammar);
+    if (!table.conflicts.empty()) {
+        out << "Error: grammar is not LL(1)";
+        return;
+    }
+    std::ifstream in(path);
+    if (!in) {
+        out << "Error: cannot read sentences from " << path;
+        return;
+    }
+    auto sentences = read_sentences(in, table.grammar);
+
+    std::vector<char> accepted(sentences.size());
+    std::vector<int> stack;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < sentences.size(); i++) {
+        accepted[i] = parse(table, sentences[i], stack) ? 1 : 0;
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    for (char result : accepted) {
+        out << (result != 0 ? "ACCEPT\n" : "REJECT\n");
+    }
+    std::cerr << "Parsed " << sentences.size() << " sentences in "
+              << elapsed.count() << " ms\n";
+}
+
+auto print_enumerated_sentences(const Grammar &grammar, size_t max_length,
+                                size_t count, std::ostream &out) -> void {
+    InternedGrammar interned = analysis::intern_grammar(grammar);
+    for (const auto &sentence :
+         enumerate_sentences(interned, max_length, count)) {
+        out << sentence_to_string(interned, sentence) << "\n";
+    }
+}
+
+// Breadth-first over leftmost derivations, shortest derivations first. Forms
+// with more than max_length terminals are dropped, and the search gives up
+// after a bounded number of forms so nullable cycles can't run forever.
+auto enumerate_sentences(const InternedGrammar &grammar, size_t max_length,
+                         size_t count) -> std::vector<std::vector<int>> {
+    const size_t max_form_length = 2 * max_length + 4;
+    const size_t max_forms = 200 * count + 1000;
+
+    std::vector<std::vector<int>> sentences;
+    std::unordered_set<std::vector<int>, FormHasher> seen;
+    std::deque<std::vector<int>> forms;
+    forms.push_back({grammar.start()});
+    seen.insert(forms.back());
+
+    while (!forms.empty() && sentences.size() < count &&
+           seen.size() < max_forms) {
+        std::vector<int> form = std::move(forms.front());
+        forms.pop_front();
+
+        auto leftmost = std::find_if(form.begin(), form.end(), [&](int s) {
+            return !grammar.is_term(s);
+        });
+        if (leftmost == form.end()) {
+            sentences.push_back(std::move(form));
+            continue;
+        }
+
+        size_t at = leftmost - form.begin();
+        for (int rule : grammar.rules_of[*leftmost - grammar.num_terms]) {
+            const std::vector<int> &rhs = grammar.rule_rhs[rule];
+            std::vector<int> next(form.begin(), form.begin() + at);
+            next.insert(next.end(), rhs.begin(), rhs.end());
+            next.insert(next.end(), form.begin() + at + 1, form.end());
+
+            size_t terminals = std::count_if(
+                next.begin(), next.end(),
+                [&](int s) { return grammar.is_term(s); });
+            if (terminals > max_length || next.size() > max_form_length) {
+                continue;
+            }
+            if (seen.insert(next).second) {
+                forms.push_back(std::move(next));
+            }
+        }
+    }
+    return sentences;
+}
+
+} // namespace ll1
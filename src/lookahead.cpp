@@ -0,0 +1,324 @@
+#include "lookahead.h"
+#include "symbols.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Worklist restricted to one strongly connected component
+class ComponentWorklist {
+  public:
+    explicit ComponentWorklist(const std::vector<int> &members)
+        : queued(members.begin(), members.end()),
+          pending(members.begin(), members.end()) {}
+
+    auto empty() const -> bool { return pending.empty(); }
+
+    auto pop() -> int {
+        int node = pending.front();
+        pending.pop_front();
+        queued.erase(node);
+        return node;
+    }
+
+    auto push(int node) -> void {
+        if (queued.insert(node).second) {
+            pending.push_back(node);
+        }
+    }
+
+  private:
+    std::unordered_set<int> queued;
+    std::deque<int> pending;
+};
+
+auto append_symbol(TupleTrie &trie, const TupleSet &prefixes, int symbol)
+    -> TupleSet {
+    TupleSet result;
+    for (int prefix : prefixes) {
+        result.insert(trie.is_complete(prefix) ? prefix
+                                               : trie.child(prefix, symbol));
+    }
+    return result;
+}
+
+auto all_complete(const TupleTrie &trie, const TupleSet &tuples) -> bool {
+    return std::all_of(tuples.begin(), tuples.end(), [&trie](int tuple) {
+        return trie.is_complete(tuple);
+    });
+}
+
+auto print_tuple_sets(const LookaheadSets &sets,
+                      const std::vector<TupleSet> &tuple_sets,
+                      const std::string &set_name, std::ostream &out) -> void {
+    const InternedGrammar &grammar = sets.grammar;
+    const int end_marker = grammar.num_symbols();
+
+    for (int nt = 0; nt < grammar.num_non_terms(); nt++) {
+        // Order tuples by terminal rank, with $ ahead of every terminal
+        std::vector<std::vector<int>> tuples;
+        for (int tuple : tuple_sets[nt]) {
+            std::vector<int> symbols = sets.trie.symbols(tuple);
+            for (int &symbol : symbols) {
+                symbol = symbol == end_marker ? -1 : symbol;
+            }
+            tuples.push_back(std::move(symbols));
+        }
+        std::sort(tuples.begin(), tuples.end());
+
+        std::vector<std::string> tuple_strings;
+        for (const std::vector<int> &symbols : tuples) {
+            std::vector<std::string> names;
+            for (int symbol : symbols) {
+                names.push_back(symbol == -1 ? "$" : grammar.names[symbol]);
+            }
+            tuple_strings.push_back("(" + util::join_vec_string(names, " ") +
+                                    ")");
+        }
+
+        out << set_name << "(" << grammar.names[grammar.num_terms + nt]
+            << ") = { " << util::join_vec_string(tuple_strings, ", ") << " }";
+        if (nt < grammar.num_non_terms() - 1) {
+            out << "\n";
+        }
+    }
+}
+
+} // namespace
+
+TupleTrie::TupleTrie(int k, int end_marker)
+    : k(k), end_marker(end_marker), parents{-1}, last_symbols{-1},
+      depths{0} {}
+
+auto TupleTrie::child(int node, int symbol) -> int {
+    uint64_t key = (static_cast<uint64_t>(node) << 32) |
+                   static_cast<uint32_t>(symbol);
+    auto found = children.find(key);
+    if (found != children.end()) {
+        return found->second;
+    }
+
+    int id = static_cast<int>(parents.size());
+    parents.push_back(node);
+    last_symbols.push_back(symbol);
+    depths.push_back(depths[node] + 1);
+    children.emplace(key, id);
+    return id;
+}
+
+// Truncated concatenation: prefix followed by suffix, cut to length k. A
+// tuple ending in $ can't be extended.
+auto TupleTrie::concat(int prefix, int suffix) -> int {
+    if (is_complete(prefix)) {
+        return prefix;
+    }
+    int node = prefix;
+    for (int symbol : symbols(suffix)) {
+        if (is_complete(node)) {
+            break;
+        }
+        node = child(node, symbol);
+    }
+    return node;
+}
+
+auto TupleTrie::symbols(int node) const -> std::vector<int> {
+    std::vector<int> result(depths[node]);
+    for (int i = depths[node] - 1; i >= 0; i--) {
+        result[i] = last_symbols[node];
+        node = parents[node];
+    }
+    return result;
+}
+
+auto TupleTrie::is_complete(int node) const -> bool {
+    return depths[node] >= k || last_symbols[node] == end_marker;
+}
+
+namespace analysis {
+
+auto print_first_k_sets(const Grammar &grammar, int k, std::ostream &out)
+    -> void {
+    auto sets = calc_first_k(grammar, k);
+    print_tuple_sets(sets, sets.first, "FIRST_" + std::to_string(k), out);
+}
+
+auto calc_first_k(const Grammar &grammar, int k) -> LookaheadSets {
+    LookaheadSets sets(intern_grammar(grammar), k);
+    const InternedGrammar &interned = sets.grammar;
+    const int num_terms = interned.num_terms;
+    sets.first.resize(interned.num_non_terms());
+
+    // A depends on every nonterminal in the rhs of its rules
+    std::vector<std::vector<int>> depends_on(interned.num_non_terms());
+    std::vector<std::vector<int>> depended_by(interned.num_non_terms());
+    for (size_t r = 0; r < interned.rule_lhs.size(); r++) {
+        int lhs = interned.rule_lhs[r] - num_terms;
+        for (int symbol : interned.rule_rhs[r]) {
+            if (!interned.is_term(symbol)) {
+                depends_on[lhs].push_back(symbol - num_terms);
+                depended_by[symbol - num_terms].push_back(lhs);
+            }
+        }
+    }
+
+    // Dependencies come first, so each component only iterates on itself
+    std::vector<int> component_of(interned.num_non_terms());
+    auto components = graph::strongly_connected_components(depends_on);
+    for (size_t c = 0; c < components.size(); c++) {
+        for (int nt : components[c]) {
+            component_of[nt] = static_cast<int>(c);
+        }
+    }
+
+    for (size_t c = 0; c < components.size(); c++) {
+        ComponentWorklist worklist(components[c]);
+        while (!worklist.empty()) {
+            int nt = worklist.pop();
+            size_t old_size = sets.first[nt].size();
+            for (int rule : interned.rules_of[nt]) {
+                TupleSet rule_first =
+                    first_k_of_subset(sets, interned.rule_rhs[rule], 0);
+                sets.first[nt].insert(rule_first.begin(), rule_first.end());
+            }
+
+            // If this set grew, everything in the component using it loops
+            if (sets.first[nt].size() == old_size) {
+                continue;
+            }
+            for (int user : depended_by[nt]) {
+                if (component_of[user] == static_cast<int>(c)) {
+                    worklist.push(user);
+                }
+            }
+        }
+    }
+
+    return sets;
+}
+
+auto print_follow_k_sets(const Grammar &grammar, int k, std::ostream &out)
+    -> void {
+    auto sets = calc_follow_k(grammar, k);
+    print_tuple_sets(sets, sets.follow, "FOLLOW_" + std::to_string(k), out);
+}
+
+auto calc_follow_k(const Grammar &grammar, int k) -> LookaheadSets {
+    LookaheadSets sets = calc_first_k(grammar, k);
+    const InternedGrammar &interned = sets.grammar;
+    const int num_terms = interned.num_terms;
+    sets.follow.resize(interned.num_non_terms());
+    sets.follow[0].insert(sets.trie.child(TupleTrie::EPSILON,
+                                          interned.num_symbols()));
+
+    // For A -> x B y: complete tuples of FIRST_k(y) go straight into
+    // FOLLOW_k(B); the rest still need FOLLOW_k(A) appended
+    struct Constraint {
+        int target;
+        TupleSet prefixes;
+    };
+    std::vector<std::vector<Constraint>> constraints(interned.num_non_terms());
+    std::vector<std::vector<int>> feeds(interned.num_non_terms());
+    for (size_t r = 0; r < interned.rule_lhs.size(); r++) {
+        int lhs = interned.rule_lhs[r] - num_terms;
+        const std::vector<int> &rhs = interned.rule_rhs[r];
+        for (size_t i = 0; i < rhs.size(); i++) {
+            if (interned.is_term(rhs[i])) {
+                continue;
+            }
+            int target = rhs[i] - num_terms;
+            Constraint constraint{target, TupleSet()};
+            for (int tuple : first_k_of_subset(sets, rhs, i + 1)) {
+                if (sets.trie.is_complete(tuple)) {
+                    sets.follow[target].insert(tuple);
+                } else {
+                    constraint.prefixes.insert(tuple);
+                }
+            }
+            if (!constraint.prefixes.empty()) {
+                constraints[lhs].push_back(std::move(constraint));
+                feeds[lhs].push_back(target);
+            }
+        }
+    }
+
+    // Tarjan emits sinks first; FOLLOW flows from lhs to rhs, so walk the
+    // components backwards
+    std::vector<int> component_of(interned.num_non_terms());
+    auto components = graph::strongly_connected_components(feeds);
+    std::reverse(components.begin(), components.end());
+    for (size_t c = 0; c < components.size(); c++) {
+        for (int nt : components[c]) {
+            component_of[nt] = static_cast<int>(c);
+        }
+    }
+
+    for (size_t c = 0; c < components.size(); c++) {
+        ComponentWorklist worklist(components[c]);
+        while (!worklist.empty()) {
+            int nt = worklist.pop();
+            for (const Constraint &constraint : constraints[nt]) {
+                TupleSet &target = sets.follow[constraint.target];
+                size_t old_size = target.size();
+                TupleSet added =
+                    concat_k(sets.trie, constraint.prefixes, sets.follow[nt]);
+                target.insert(added.begin(), added.end());
+
+                if (target.size() != old_size &&
+                    component_of[constraint.target] == static_cast<int>(c)) {
+                    worklist.push(constraint.target);
+                }
+            }
+        }
+    }
+
+    return sets;
+}
+
+auto concat_k(TupleTrie &trie, const TupleSet &prefixes,
+              const TupleSet &suffixes) -> TupleSet {
+    TupleSet result;
+    if (suffixes.empty()) {
+        return result;
+    }
+    for (int prefix : prefixes) {
+        if (trie.is_complete(prefix)) {
+            result.insert(prefix);
+            continue;
+        }
+        for (int suffix : suffixes) {
+            result.insert(trie.concat(prefix, suffix));
+        }
+    }
+    return result;
+}
+
+// Returns FIRST_k of symbols[start_idx:], i.e.
+// FIRST_k(X1) +k ... +k FIRST_k(Xn)
+auto first_k_of_subset(LookaheadSets &sets, const std::vector<int> &symbols,
+                       size_t start_idx) -> TupleSet {
+    TupleSet result{TupleTrie::EPSILON};
+    for (size_t i = start_idx; i < symbols.size(); i++) {
+        if (all_complete(sets.trie, result)) {
+            break;
+        }
+        if (sets.grammar.is_term(symbols[i])) {
+            result = append_symbol(sets.trie, result, symbols[i]);
+        } else {
+            result = concat_k(sets.trie, result,
+                              sets.first[symbols[i] - sets.grammar.num_terms]);
+        }
+        // An unproductive symbol makes the whole sequence unproductive
+        if (result.empty()) {
+            break;
+        }
+    }
+    return result;
+}
+
+} // namespace analysis
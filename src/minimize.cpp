@@ -0,0 +1,224 @@
+#include "minimize.h"
+#include "analysis.h"
+#include "output.h"
+#include "symbols.h"
+#include "types.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Rules of nt with every nonterminal replaced by its class, sorted and
+// deduplicated, then flattened as (length, symbols...) per rule. Classes
+// are numbered after the terminals so the two can't collide.
+auto signature_of(const InternedGrammar &grammar, int nt,
+                  const std::vector<int> &block) -> std::vector<int> {
+    std::vector<std::vector<int>> rules;
+    for (int rule : grammar.rules_of[nt]) {
+        std::vector<int> rhs;
+        rhs.reserve(grammar.rule_rhs[rule].size());
+        for (int symbol : grammar.rule_rhs[rule]) {
+            rhs.push_back(grammar.is_term(symbol)
+                              ? symbol
+                              : grammar.num_terms +
+                                    block[symbol - grammar.num_terms]);
+        }
+        rules.push_back(std::move(rhs));
+    }
+    std::sort(rules.begin(), rules.end());
+    rules.erase(std::unique(rules.begin(), rules.end()), rules.end());
+
+    std::vector<int> signature;
+    for (const std::vector<int> &rhs : rules) {
+        signature.push_back(static_cast<int>(rhs.size()));
+        signature.insert(signature.end(), rhs.begin(), rhs.end());
+    }
+    return signature;
+}
+
+// Time to compute FIRST and FOLLOW, the first thing later passes need
+auto analysis_ms(const Grammar &grammar) -> double {
+    auto start = std::chrono::steady_clock::now();
+    analysis::calc_first(grammar);
+    analysis::calc_follow(grammar);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace
+
+namespace minimize {
+
+auto equivalence_classes(const Grammar &grammar) -> std::vector<int> {
+    const InternedGrammar interned = analysis::intern_grammar(grammar);
+    const int num_non_terms = interned.num_non_terms();
+
+    // users[nt]: nonterminals with a rule mentioning nt
+    std::vector<std::vector<int>> users(num_non_terms);
+    for (size_t r = 0; r < interned.rule_rhs.size(); r++) {
+        int lhs = interned.rule_lhs[r] - interned.num_terms;
+        for (int symbol : interned.rule_rhs[r]) {
+            if (!interned.is_term(symbol)) {
+                std::vector<int> &list = users[symbol - interned.num_terms];
+                if (list.empty() || list.back() != lhs) {
+                    list.push_back(lhs);
+                }
+            }
+        }
+    }
+
+    std::vector<int> block(num_non_terms, 0);
+    std::vector<std::vector<int>> members(1);
+    for (int nt = 0; nt < num_non_terms; nt++) {
+        members[0].push_back(nt);
+    }
+    std::vector<std::vector<int>> signature(num_non_terms);
+
+    // Main Loop: a signature only goes stale when a nonterminal it mentions
+    // moves to another class, so only those users are recomputed. Blocks
+    // only ever split, which bounds the number of rounds.
+    std::vector<int> dirty(members[0]);
+    std::vector<char> is_dirty(num_non_terms, 1);
+    while (!dirty.empty()) {
+        std::vector<int> touched;
+        for (int nt : dirty) {
+            signature[nt] = signature_of(interned, nt, block);
+            is_dirty[nt] = 0;
+            touched.push_back(block[nt]);
+        }
+        dirty.clear();
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()),
+                      touched.end());
+
+        std::vector<int> moved;
+        for (int b : touched) {
+            std::map<std::vector<int>, std::vector<int>> groups;
+            for (int nt : members[b]) {
+                groups[signature[nt]].push_back(nt);
+            }
+            if (groups.size() == 1) {
+                continue;
+            }
+
+            // The group of the block's first member keeps its number
+            const std::vector<int> &kept = signature[members[b][0]];
+            for (auto &group : groups) {
+                if (group.first == kept) {
+                    members[b] = std::move(group.second);
+                    continue;
+                }
+                int new_block = static_cast<int>(members.size());
+                for (int nt : group.second) {
+                    block[nt] = new_block;
+                    moved.push_back(nt);
+                }
+                members.push_back(std::move(group.second));
+            }
+        }
+
+        for (int nt : moved) {
+            for (int user : users[nt]) {
+                if (is_dirty[user] == 0) {
+                    is_dirty[user] = 1;
+                    dirty.push_back(user);
+                }
+            }
+        }
+    }
+    return block;
+}
+
+auto merge_equivalent_non_terms(const Grammar &grammar, MergeStats *stats)
+    -> Grammar {
+    auto start = std::chrono::steady_clock::now();
+    const std::vector<int> block = equivalence_classes(grammar);
+    const std::vector<std::string> &order = grammar.non_term_order;
+
+    // First member of each class in non_term_order stands for it
+    std::vector<int> representative(order.size(), -1);
+    std::unordered_map<std::string, const std::string *> rename;
+    Grammar merged;
+    merged.terms = grammar.terms;
+    merged.term_order = grammar.term_order;
+    for (size_t i = 0; i < order.size(); i++) {
+        int &rep = representative[block[i]];
+        if (rep == -1) {
+            rep = static_cast<int>(i);
+            merged.non_terms.insert(order[i]);
+            merged.non_term_order.push_back(order[i]);
+        }
+        rename.emplace(order[i], &order[rep]);
+    }
+
+    std::unordered_set<Rule, RuleHasher> seen;
+    for (const Rule &rule : grammar.rules) {
+        const std::string &lhs = *rename.at(rule.lhs);
+        if (lhs != rule.lhs) {
+            continue;
+        }
+        IDList rhs;
+        rhs.reserve(rule.rhs.size());
+        for (const std::string &symbol : rule.rhs) {
+            auto found = rename.find(symbol);
+            rhs.push_back(found == rename.end() ? symbol : *found->second);
+        }
+        Rule renamed(lhs, rhs);
+        if (seen.insert(renamed).second) {
+            merged.rules.push_back(std::move(renamed));
+        }
+    }
+
+    if (stats != nullptr) {
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        stats->rules_before = grammar.rules.size();
+        stats->rules_after = merged.rules.size();
+        stats->non_terms_before = order.size();
+        stats->non_terms_after = merged.non_term_order.size();
+        stats->merge_ms = elapsed.count();
+    }
+    return merged;
+}
+
+auto merge_transformed(std::vector<Rule> rules, bool compare, std::ostream &log)
+    -> Grammar {
+    output::sort_rules_as_text(rules);
+    Grammar transformed = analysis::grammar_from_rules(std::move(rules));
+    MergeStats stats;
+    Grammar merged = merge_equivalent_non_terms(transformed, &stats);
+    print_merge_stats(stats, log);
+
+    if (compare) {
+        double unmerged_ms = analysis_ms(transformed);
+        double merged_ms = analysis_ms(merged);
+        log << "FIRST/FOLLOW: " << unmerged_ms << " ms unmerged, " << merged_ms
+            << " ms merged, saved " << unmerged_ms - merged_ms - stats.merge_ms
+            << " ms\n";
+    }
+    return merged;
+}
+
+auto print_merged_grammar(const Grammar &grammar, std::ostream &out) -> void {
+    MergeStats stats;
+    Grammar merged = merge_equivalent_non_terms(grammar, &stats);
+    analysis::print_rules(merged.rules, out);
+    print_merge_stats(stats, std::cerr);
+}
+
+auto print_merge_stats(const MergeStats &stats, std::ostream &out) -> void {
+    out << "Merged: rules " << stats.rules_before << " -> "
+        << stats.rules_after << ", nonterminals " << stats.non_terms_before
+        << " -> " << stats.non_terms_after << " (" << stats.merge_ms
+        << " ms)\n";
+}
+
+} // namespace minimize
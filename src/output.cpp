@@ -0,0 +1,262 @@
+#include "output.h"
+#include "analysis.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint8_t RECORD_SYMBOL = 1;
+const uint8_t RECORD_SET = 2;
+const uint8_t RECORD_RULE = 3;
+const uint8_t RECORD_STAGE = 4;
+
+auto write_u8(std::ostream &out, uint8_t value) -> void {
+    out.put(static_cast<char>(value));
+}
+
+auto write_u32(std::ostream &out, uint32_t value) -> void {
+    char bytes[4] = {static_cast<char>(value & 0xFF),
+                     static_cast<char>((value >> 8) & 0xFF),
+                     static_cast<char>((value >> 16) & 0xFF),
+                     static_cast<char>((value >> 24) & 0xFF)};
+    out.write(bytes, 4);
+}
+
+auto write_string(std::ostream &out, const std::string &value) -> void {
+    write_u32(out, static_cast<uint32_t>(value.size()));
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+auto write_json_string(std::ostream &out, const std::string &value) -> void {
+    out.put('"');
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+    out.put('"');
+}
+
+// Strings pointed to by items, each via get(item)
+template <typename T, typename Get>
+auto write_json_list(std::ostream &out, const std::vector<T> &items, Get get)
+    -> void {
+    out.put('[');
+    for (size_t i = 0; i < items.size(); i++) {
+        if (i > 0) {
+            out.put(',');
+        }
+        write_json_string(out, get(items[i]));
+    }
+    out.put(']');
+}
+
+template <typename T, typename Get>
+auto list_size(const std::vector<T> &items, Get get) -> uint32_t {
+    size_t size = 4;
+    for (const T &item : items) {
+        size += 4 + get(item).size();
+    }
+    return static_cast<uint32_t>(size);
+}
+
+template <typename T, typename Get>
+auto write_list(std::ostream &out, const std::vector<T> &items, Get get)
+    -> void {
+    write_u32(out, static_cast<uint32_t>(items.size()));
+    for (const T &item : items) {
+        write_string(out, get(item));
+    }
+}
+
+auto deref(const std::string *name) -> const std::string & { return *name; }
+auto same(const std::string &name) -> const std::string & { return name; }
+
+auto write_symbol(const std::string &name, bool non_term, OutputFormat format,
+                  std::ostream &out) -> void {
+    if (format == OutputFormat::NDJSON) {
+        out << (non_term ? "{\"kind\":\"nonterminal\",\"name\":"
+                         : "{\"kind\":\"terminal\",\"name\":");
+        write_json_string(out, name);
+        out << "}\n";
+        return;
+    }
+    write_u32(out, static_cast<uint32_t>(2 + 4 + name.size()));
+    write_u8(out, RECORD_SYMBOL);
+    write_u8(out, non_term ? 1 : 0);
+    write_string(out, name);
+}
+
+auto write_set(const std::string &set_name, const std::string *symbol,
+               const std::vector<const std::string *> &members,
+               OutputFormat format, std::ostream &out) -> void {
+    if (format == OutputFormat::NDJSON) {
+        out << "{\"set\":";
+        write_json_string(out, set_name);
+        if (symbol != nullptr) {
+            out << ",\"symbol\":";
+            write_json_string(out, *symbol);
+        }
+        out << ",\"members\":";
+        write_json_list(out, members, deref);
+        out << "}\n";
+        return;
+    }
+    size_t symbol_size = symbol != nullptr ? symbol->size() : 0;
+    write_u32(out, static_cast<uint32_t>(1 + 4 + set_name.size() + 4 +
+                                         symbol_size) +
+                       list_size(members, deref));
+    write_u8(out, RECORD_SET);
+    write_string(out, set_name);
+    write_u32(out, static_cast<uint32_t>(symbol_size));
+    if (symbol != nullptr) {
+        out.write(symbol->data(), static_cast<std::streamsize>(symbol_size));
+    }
+    write_list(out, members, deref);
+}
+
+// Walks the characters of rule.to_string() without building it
+class RuleText {
+  public:
+    explicit RuleText(const Rule &rule) : rule(rule) {}
+
+    // Next character, or -1 at the end
+    auto next() -> int {
+        while (true) {
+            const std::string *piece = current_piece();
+            if (piece == nullptr) {
+                return -1;
+            }
+            if (offset < piece->size()) {
+                return static_cast<unsigned char>((*piece)[offset++]);
+            }
+            part++;
+            offset = 0;
+        }
+    }
+
+  private:
+    const Rule &rule;
+    size_t part = 0; // lhs, " -> ", then rhs symbols and " " alternately
+    size_t offset = 0;
+
+    auto current_piece() const -> const std::string * {
+        static const std::string arrow = " -> ";
+        static const std::string space = " ";
+        static const std::string end = " #";
+        if (part == 0) {
+            return &rule.lhs;
+        }
+        if (part == 1) {
+            return &arrow;
+        }
+        size_t body = part - 2;
+        size_t body_parts = rule.rhs.empty() ? 0 : 2 * rule.rhs.size() - 1;
+        if (body < body_parts) {
+            return body % 2 == 0 ? &rule.rhs[body / 2] : &space;
+        }
+        return body == body_parts ? &end : nullptr;
+    }
+};
+
+auto rule_text_less(const Rule &a, const Rule &b) -> bool {
+    RuleText left(a);
+    RuleText right(b);
+    while (true) {
+        int l = left.next();
+        int r = right.next();
+        if (l != r) {
+            return l < r;
+        }
+        if (l == -1) {
+            return false;
+        }
+    }
+}
+
+} // namespace
+
+namespace output {
+
+auto parse_format(const std::string &name, OutputFormat &format) -> bool {
+    if (name == "text") {
+        format = OutputFormat::TEXT;
+    } else if (name == "ndjson") {
+        format = OutputFormat::NDJSON;
+    } else if (name == "binary") {
+        format = OutputFormat::BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+auto write_symbols(const Grammar &grammar, OutputFormat format,
+                   std::ostream &out) -> void {
+    for (const std::string &term : grammar.term_order) {
+        write_symbol(term, false, format, out);
+    }
+    for (const std::string &non_term : grammar.non_term_order) {
+        write_symbol(non_term, true, format, out);
+    }
+}
+
+auto write_nullable(const Grammar &grammar, OutputFormat format,
+                    std::ostream &out) -> void {
+    auto nullable = analysis::calc_nullable(grammar);
+    const util::RankIndex rank = util::rank_index(grammar.non_term_order);
+    static const std::string set_name = "Nullable";
+    write_set(set_name, nullptr, util::generate_ordered_vec(nullable, rank),
+              format, out);
+}
+
+auto write_set_map(const SetMap &map, const Grammar &grammar,
+                   const std::string &set_name, OutputFormat format,
+                   std::ostream &out) -> void {
+    const util::RankIndex term_rank = util::rank_index(grammar.term_order);
+    for (const std::string &non_term : grammar.non_term_order) {
+        write_set(set_name, &non_term,
+                  util::generate_ordered_vec(map.at(non_term), term_rank),
+                  format, out);
+    }
+}
+
+auto write_rules(std::vector<Rule> &rules, OutputFormat format,
+                 std::ostream &out) -> void {
+    sort_rules_as_text(rules);
+    for (const Rule &rule : rules) {
+        if (format == OutputFormat::NDJSON) {
+            out << "{\"lhs\":";
+            write_json_string(out, rule.lhs);
+            out << ",\"rhs\":";
+            write_json_list(out, rule.rhs, same);
+            out << "}\n";
+            continue;
+        }
+        write_u32(out, static_cast<uint32_t>(1 + 4 + rule.lhs.size()) +
+                           list_size(rule.rhs, same));
+        write_u8(out, RECORD_RULE);
+        write_string(out, rule.lhs);
+        write_list(out, rule.rhs, same);
+    }
+}
+
+auto write_stage(const std::string &name, OutputFormat format,
+                 std::ostream &out) -> void {
+    if (format == OutputFormat::NDJSON) {
+        out << "{\"stage\":";
+        write_json_string(out, name);
+        out << "}\n";
+        return;
+    }
+    write_u32(out, static_cast<uint32_t>(1 + 4 + name.size()));
+    write_u8(out, RECORD_STAGE);
+    write_string(out, name);
+}
+
+auto sort_rules_as_text(std::vector<Rule> &rules) -> void {
+    std::sort(rules.begin(), rules.end(), rule_text_less);
+}
+
+} // namespace output
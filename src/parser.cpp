@@ -1,15 +1,26 @@
 #include "parser.h"
 #include "lexer.h"
+#include "probes.h"
 #include "util.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 Parser::Parser() = default;
 
+Parser::Parser(std::istream &in) : lexer(in) {}
+
 void Parser::parse_input() {
+    PROBE0(parse_start);
     parse_grammar();
     expect(END_OF_FILE);
+    PROBE2(parse_done, rules.size(), universe_order.size());
 }
 
 void Parser::parse_grammar() {
@@ -19,17 +30,33 @@ void Parser::parse_grammar() {
 }
 
 void Parser::parse_rule_list() {
-    auto result = parse_rule();
-    util::merge_vectors(rules, result);
-    if (parser_util::starts_rule(lexer.peek(1))) {
+    /*Rule-list → Rule Rule-list | Rule*/
+    // A loop rather than recursion, so long grammars can't overflow the stack
+    do {
+        util::merge_vectors(rules, parse_rule());
+    } while (parser_util::starts_rule(lexer.peek(1)));
+}
+
+void Parser::parse_chunk(bool first, bool last) {
+    if (first || parser_util::starts_rule(lexer.peek(1))) {
         parse_rule_list();
     }
+    if (last) {
+        expect(HASH);
+    }
+    expect(END_OF_FILE);
+}
+
+auto Parser::take_chunk() -> ParsedChunk {
+    return ParsedChunk{std::move(rules), std::move(universe_order),
+                       std::move(non_terms)};
 }
 
 auto Parser::parse_rule() -> std::vector<Rule> {
     /*Rule → ID ARROW Right-hand-side STAR*/
-    Token rule_id = expect(ID);
+    const Token &rule_id = expect(ID);
     update_universe(rule_id);
+    current_lhs = rule_id.lexeme;
     expect(ARROW);
     auto rhs = parse_rhs();
     expect(STAR);
@@ -38,7 +65,7 @@ auto Parser::parse_rule() -> std::vector<Rule> {
     std::vector<Rule> rules;
     rules.reserve(rhs.size());
     for (IDList &id_list : rhs) {
-        rules.emplace_back(rule_id.lexeme, id_list);
+        rules.emplace_back(rule_id.lexeme, std::move(id_list));
     }
 
     return rules;
@@ -56,21 +83,168 @@ auto Parser::parse_rhs() -> std::vector<IDList> {
     return id_lists;
 }
 
-auto Parser::parse_id_list() -> IDList { /*Id-list → ID Id-list | epsilon*/
+auto Parser::parse_id_list() -> IDList { /*Id-list → Item Id-list | epsilon*/
     IDList id_list;
     if (parser_util::is_follow_id_list(lexer.peek(1))) { // Epsilon
         return id_list;
     }
 
-    Token id_tok = expect(ID);
-    id_list.push_back(id_tok.lexeme);
-    update_universe(id_tok);
+    // A loop rather than recursion, so each item is moved into place once
+    do {
+        util::merge_vectors(id_list, parse_item());
+    } while (parser_util::starts_item(lexer.peek(1)));
+
+    return id_list;
+}
 
-    if (lexer.peek(1).token_type == ID) {
-        util::merge_vectors(id_list, parse_id_list());
+auto Parser::parse_item() -> IDList {
+    /*Item → Primary | Primary PLUS*/
+    IDList item = parse_primary();
+    if (lexer.peek(1).token_type == PLUS) {
+        expect(PLUS);
+        // x+ is x {x}
+        util::merge_vectors(item, repetition({item}));
     }
+    return item;
+}
 
-    return id_list;
+auto Parser::parse_primary() -> IDList {
+    /*Primary → ID | LPAREN Rhs RPAREN | LBRAC Rhs RBRAC | LBRACE Rhs RBRACE*/
+    const Token &tok = lexer.peek(1);
+    if (tok.token_type == ID) {
+        const Token &id_tok = expect(ID);
+        update_universe(id_tok);
+        return IDList(1, id_tok.lexeme);
+    }
+
+    std::vector<IDList> alternatives;
+    if (tok.token_type == LPAREN) {
+        expect(LPAREN);
+        alternatives = parse_rhs();
+        expect(RPAREN);
+        return group(std::move(alternatives));
+    }
+    if (tok.token_type == LBRAC) {
+        expect(LBRAC);
+        alternatives = parse_rhs();
+        expect(RBRAC);
+        alternatives.emplace_back(); // [x] is (x | epsilon)
+        return group(std::move(alternatives), "Opt");
+    }
+    expect(LBRACE);
+    alternatives = parse_rhs();
+    expect(RBRACE);
+    return repetition(std::move(alternatives));
+}
+
+namespace {
+// Drops repeated alternatives, keeping first occurrences in order
+auto unique_alternatives(std::vector<IDList> alternatives)
+    -> std::vector<IDList> {
+    std::vector<IDList> unique;
+    for (IDList &alternative : alternatives) {
+        if (std::find(unique.begin(), unique.end(), alternative) ==
+            unique.end()) {
+            unique.push_back(std::move(alternative));
+        }
+    }
+    return unique;
+}
+
+const char PLACEHOLDER = '\x01';
+} // namespace
+
+auto Parser::group(std::vector<IDList> alternatives, const std::string &name)
+    -> IDList {
+    alternatives = unique_alternatives(std::move(alternatives));
+    // A single alternative is spliced into the enclosing sequence
+    if (alternatives.size() == 1) {
+        return std::move(alternatives[0]);
+    }
+    return {helper(false, name, std::move(alternatives))};
+}
+
+auto Parser::repetition(std::vector<IDList> alternatives) -> IDList {
+    // Empty alternatives add nothing to a repetition
+    alternatives.erase(std::remove_if(alternatives.begin(), alternatives.end(),
+                                      [](const IDList &alternative) {
+                                          return alternative.empty();
+                                      }),
+                       alternatives.end());
+    alternatives = unique_alternatives(std::move(alternatives));
+    if (alternatives.empty()) {
+        return {};
+    }
+    return {helper(true, "Rep", std::move(alternatives))};
+}
+
+auto Parser::helper(bool recursive, const std::string &name,
+                    std::vector<IDList> alternatives) -> std::string {
+    // [x] and (x |) share a key; the name only reflects the first use
+    std::string key = recursive ? "Rep" : "Group";
+    for (const IDList &alternative : alternatives) {
+        key += " |";
+        for (const std::string &symbol : alternative) {
+            key += ' ';
+            key += symbol;
+        }
+    }
+    auto found = helper_by_key.find(key);
+    if (found != helper_by_key.end()) {
+        return found->second;
+    }
+
+    std::string placeholder =
+        std::string(1, PLACEHOLDER) + std::to_string(helpers.size());
+    helpers.push_back(Helper{current_lhs, name});
+    helper_by_key.emplace(std::move(key), placeholder);
+
+    // Rep: H -> x1 H | ... | xn H | epsilon
+    for (IDList &alternative : alternatives) {
+        helper_rules.emplace_back(placeholder, std::move(alternative));
+        if (recursive) {
+            helper_rules.back().rhs.push_back(placeholder);
+        }
+    }
+    if (recursive) {
+        helper_rules.emplace_back(placeholder, IDList());
+    }
+    return placeholder;
+}
+
+void Parser::name_helpers() {
+    // <lhs><kind><n>, skipping names the grammar already uses
+    std::vector<std::string> names;
+    std::unordered_set<std::string> used;
+    std::unordered_map<std::string, int> counts;
+    for (const Helper &helper : helpers) {
+        std::string prefix = helper.base + helper.name;
+        std::string name;
+        do {
+            name = prefix + std::to_string(++counts[prefix]);
+        } while (universe.count(name) != 0 || used.count(name) != 0);
+        used.insert(name);
+        names.push_back(name);
+    }
+
+    auto rename = [&names](std::string &symbol) {
+        if (!symbol.empty() && symbol[0] == PLACEHOLDER) {
+            symbol = names[std::stoul(symbol.substr(1))];
+        }
+    };
+    util::merge_vectors(rules, std::move(helper_rules));
+    for (Rule &rule : rules) {
+        rename(rule.lhs);
+        for (std::string &symbol : rule.rhs) {
+            rename(symbol);
+        }
+    }
+
+    // Helpers follow the grammar's own nonterminals
+    for (const std::string &name : names) {
+        non_terms.insert(name);
+    }
+    helper_names = std::move(names);
 }
 
 void Parser::update_universe(const Token &tok) {
@@ -88,6 +262,9 @@ void Parser::update_universe(const Token &tok) {
 }
 
 auto Parser::generate_grammar() -> Grammar {
+    if (!helpers.empty()) {
+        name_helpers();
+    }
     for (const std::string &id : universe_order) {
         if (non_terms.count(id) == 0) {
             terms.insert(id);
@@ -96,21 +273,19 @@ auto Parser::generate_grammar() -> Grammar {
             non_term_order.push_back(id);
         }
     }
+    util::merge_vectors(non_term_order, std::move(helper_names));
 
     return Grammar{std::move(non_terms), std::move(terms),
                    std::move(non_term_order), std::move(term_order),
                    std::move(rules)};
 }
 
-void Parser::syntax_error() {
-    std::cout << "SYNTAX ERROR !!!!!!!!!!!!!!\n";
-    exit(1);
-}
+void Parser::syntax_error(int line) { throw SyntaxError(line); }
 
-auto Parser::expect(TokenType expected_type) -> Token {
-    Token token = lexer.GetToken();
+auto Parser::expect(TokenType expected_type) -> const Token & {
+    const Token &token = lexer.GetToken();
     if (token.token_type != expected_type) {
-        syntax_error();
+        syntax_error(token.line_no);
     }
     return token;
 }
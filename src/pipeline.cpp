@@ -0,0 +1,196 @@
+#include "pipeline.h"
+#include "analysis.h"
+#include "budget.h"
+#include "consts.h"
+#include "minimize.h"
+#include "output.h"
+#include "tasks.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct StageInfo {
+    const char *name;
+    PipelineStage stage;
+    int task;
+    bool transform;
+};
+
+const StageInfo STAGES[] = {
+    {"reduce", PipelineStage::REDUCE, TASK_10, true},
+    {"unleftrec", PipelineStage::UNLEFTREC, TASK_6, true},
+    {"factor", PipelineStage::FACTOR, TASK_5, true},
+    {"merge", PipelineStage::MERGE, TASK_16, true},
+    {"symbols", PipelineStage::SYMBOLS, TASK_1, false},
+    {"nullable", PipelineStage::NULLABLE, TASK_2, false},
+    {"first", PipelineStage::FIRST, TASK_3, false},
+    {"follow", PipelineStage::FOLLOW, TASK_4, false},
+};
+
+auto info_of(PipelineStage stage) -> const StageInfo & {
+    for (const StageInfo &info : STAGES) {
+        if (info.stage == stage) {
+            return info;
+        }
+    }
+    return STAGES[0];
+}
+
+// The grammar is consumed; the caller rebuilds it from the rules
+auto run_transform(Grammar &grammar, PipelineStage stage,
+                   const TaskOptions &options) -> std::vector<Rule> {
+    switch (stage) {
+    case PipelineStage::REDUCE:
+        return analysis::remove_useless_symbols(grammar).rules;
+    case PipelineStage::MERGE:
+        return minimize::merge_equivalent_non_terms(grammar).rules;
+    case PipelineStage::UNLEFTREC:
+        return analysis::eliminate_left_recursion(std::move(grammar));
+    default:
+        return options.factor_conflicts
+                   ? analysis::calc_left_factored_conflicts(std::move(grammar))
+                   : analysis::calc_left_factored(std::move(grammar));
+    }
+}
+
+// Lists the rules as the input would: the nonterminals the stage started
+// with in their old order, so the start symbol stays first, then the ones it
+// added. Rebuilt from that list, each new nonterminal follows the first one
+// whose rules use it. Rules of one nonterminal keep their order.
+auto rebuild_grammar(std::vector<Rule> rules,
+                     const std::vector<std::string> &non_term_order)
+    -> Grammar {
+    const util::RankIndex rank = util::rank_index(non_term_order);
+    auto rank_of = [&](const Rule &rule) {
+        auto found = rank.find(rule.lhs);
+        return found != rank.end() ? found->second : rank.size();
+    };
+    std::stable_sort(rules.begin(), rules.end(),
+                     [&](const Rule &a, const Rule &b) {
+                         return rank_of(a) < rank_of(b);
+                     });
+    return analysis::grammar_from_rules(std::move(rules));
+}
+
+// Rules already sorted by their text, printed as print_rules would
+auto print_sorted_rules(const std::vector<Rule> &rules, std::ostream &out)
+    -> void {
+    for (size_t i = 0; i < rules.size(); i++) {
+        if (i > 0) {
+            out << "\n";
+        }
+        analysis::print_rule(rules[i], out);
+    }
+}
+
+auto print_header(const char *name, OutputFormat format, std::ostream &out)
+    -> void {
+    if (format == OutputFormat::TEXT) {
+        out << "== " << name << " ==\n";
+    } else {
+        output::write_stage(name, format, out);
+    }
+}
+
+} // namespace
+
+namespace pipeline {
+
+auto parse_stages(const std::string &spec, std::vector<PipelineStage> &stages,
+                  std::string &bad) -> bool {
+    std::istringstream in(spec);
+    std::string name;
+    while (std::getline(in, name, ',')) {
+        bool found = false;
+        for (const StageInfo &info : STAGES) {
+            if (name == info.name) {
+                stages.push_back(info.stage);
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            bad = name;
+            return false;
+        }
+    }
+    if (stages.empty()) {
+        bad = spec;
+        return false;
+    }
+    return true;
+}
+
+auto run_pipeline(Grammar grammar, const std::vector<PipelineStage> &stages,
+                  bool dump, const TaskOptions &options, std::ostream &out)
+    -> bool {
+    auto prints = [&](size_t i) {
+        return !info_of(stages[i]).transform || dump || i + 1 == stages.size();
+    };
+    size_t sections = 0;
+    for (size_t i = 0; i < stages.size(); i++) {
+        sections += prints(i) ? 1 : 0;
+    }
+
+    const OutputFormat format = options.format;
+    size_t printed = 0;
+    bool line_open = false; // text printed since the last newline
+    try {
+        for (size_t i = 0; i < stages.size(); i++) {
+            const StageInfo &info = info_of(stages[i]);
+            if (prints(i)) {
+                if (printed > 0 && format == OutputFormat::TEXT) {
+                    out << "\n";
+                }
+                line_open = false;
+                if (sections > 1) {
+                    print_header(info.name, format, out);
+                }
+                printed++;
+            }
+
+            if (!info.transform) {
+                tasks::run_task(info.task, grammar, options, out);
+                line_open = true;
+                continue;
+            }
+
+            // The transform consumes the grammar, order included
+            const std::vector<std::string> non_term_order =
+                grammar.non_term_order;
+            std::vector<Rule> rules =
+                run_transform(grammar, info.stage, options);
+            output::sort_rules_as_text(rules);
+            if (prints(i)) {
+                if (format == OutputFormat::TEXT) {
+                    print_sorted_rules(rules, out);
+                } else {
+                    output::write_rules(rules, format, out);
+                }
+                line_open = true;
+            }
+            grammar = rebuild_grammar(std::move(rules), non_term_order);
+            if (grammar.rules.empty() && i + 1 < stages.size()) {
+                out << (printed > 0 ? "\n" : "")
+                    << "Error: no rules left after " << info.name;
+                return false;
+            }
+        }
+    } catch (const BudgetExceeded &) {
+        // Sections already printed stay; the error goes on a line of its own
+        if (line_open && format == OutputFormat::TEXT) {
+            out << "\n";
+        }
+        throw;
+    }
+    return true;
+}
+
+} // namespace pipeline
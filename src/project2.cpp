@@ -4,51 +4,215 @@
  * Do not share this file with anyone
  */
 #include "analysis.h"
+#include "budget.h"
 #include "consts.h"
+#include "ingest.h"
 #include "parser.h"
+#include "pipeline.h"
+#include "server.h"
+#include "tasks.h"
 #include "types.h"
 #include "util.h"
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
+// Runs fn and returns how long it took in milliseconds
+template <typename Fn> auto time_ms(Fn fn) -> double {
+    auto start = chrono::steady_clock::now();
+    fn();
+    chrono::duration<double, milli> elapsed =
+        chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// Runs the grammar transform behind Task 5 or Task 6
+auto run_transform(const Grammar &grammar, int task,
+                   const TaskOptions &options) -> vector<Rule> {
+    if (task != TASK_5) {
+        return analysis::eliminate_left_recursion(grammar);
+    }
+    return options.factor_conflicts
+               ? analysis::calc_left_factored_conflicts(grammar)
+               : analysis::calc_left_factored(grammar);
+}
+
 /*
- * Task 1:
- * Printing the terminals, then nonterminals of grammar in appearing order
- * output is one line, and all names are space delineated
+ * Removes useless symbols ahead of Task 5 or 6 and reports on stderr how
+ * much the grammar shrank. When compare is set, the transform is also run on
+ * both grammars to measure the time saved downstream.
  */
-void Task1(const Grammar &grammar) {
-    std::string terms = util::join_vec_string(grammar.term_order, " ");
-    std::string non_terms = util::join_vec_string(grammar.non_term_order, " ");
-    std::cout << terms << " " << non_terms;
+auto reduce_for_transform(const Grammar &grammar, int task,
+                          const TaskOptions &options, bool compare)
+    -> Grammar {
+    Grammar reduced;
+    double reduce_time =
+        time_ms([&]() { reduced = analysis::remove_useless_symbols(grammar); });
+
+    cerr << "Reduced: rules " << grammar.rules.size() << " -> "
+         << reduced.rules.size() << ", nonterminals "
+         << grammar.non_terms.size() << " -> " << reduced.non_terms.size()
+         << ", terminals " << grammar.terms.size() << " -> "
+         << reduced.terms.size() << " (" << reduce_time << " ms)\n";
+
+    if (compare) {
+        double full_time =
+            time_ms([&]() { run_transform(grammar, task, options); });
+        double reduced_time =
+            time_ms([&]() { run_transform(reduced, task, options); });
+        cerr << "Task " << task << ": " << full_time << " ms unreduced, "
+             << reduced_time << " ms reduced, saved "
+             << full_time - reduced_time - reduce_time << " ms\n";
+    }
+    return reduced;
 }
 
 /*
- * Task 2:
- * Print out nullable set of the grammar in specified format.
+ * Command line options, all of the form --name or --name=value. They follow
+ * the task number, or replace it when running a pipeline, a server or a load
+ * generator.
  */
-void Task2(const Grammar &grammar) { analysis::print_nullable_set(grammar); }
+struct Options {
+    TaskOptions task_options;
+    bool reduce = false;
+    bool reduce_compare = false;
+    bool parallel_ingest = false;
+    size_t chunk_bytes = ingest::MIN_CHUNK_BYTES;
 
-// Task 3: FIRST sets
-void Task3(const Grammar &grammar) { analysis::print_first_sets(grammar); }
+    std::vector<PipelineStage> pipeline;
+    bool dump_stages = false;
+    Budget budget;
 
-// Task 4: FOLLOW sets
-void Task4(const Grammar &grammar) { analysis::print_follow_sets(grammar); }
+    string serve;
+    size_t cache_capacity = server::DEFAULT_CACHE_CAPACITY;
+    server::LoadOptions load;
+};
 
-// Task 5: left factoring
-void Task5(const Grammar &grammar) {
-    analysis::print_left_factored_grammar(grammar);
+// Matches "--name=value" and points value at the text after '='
+auto option_value(const char *arg, const char *name, const char *&value)
+    -> bool {
+    size_t length = strlen(name);
+    if (strncmp(arg, name, length) != 0 || arg[length] != '=') {
+        return false;
+    }
+    value = arg + length + 1;
+    return true;
 }
 
-// Task 6: eliminate left recursion
-void Task6(const Grammar &grammar) {
-    analysis::print_grammar_without_left_recursion(grammar);
+// Matches "--name=N" for a positive N that fits in a size_t, such as a byte
+// budget past what an int holds
+auto size_value(const char *arg, const char *name, size_t &size) -> bool {
+    const char *value = nullptr;
+    if (!option_value(arg, name, value) ||
+        isdigit(static_cast<unsigned char>(value[0])) == 0) {
+        return false;
+    }
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed == 0 || parsed > SIZE_MAX) {
+        return false;
+    }
+    size = static_cast<size_t>(parsed);
+    return true;
+}
+
+auto parse_options(int argc, char *argv[], int first, int task,
+                   Options &options) -> bool {
+    for (int i = first; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = nullptr;
+        if (option_value(arg, "--k", value) && atoi(value) > 0) {
+            options.task_options.k = atoi(value);
+        } else if (option_value(arg, "--sentences", value)) {
+            options.task_options.sentences_path = value;
+        } else if (option_value(arg, "--length", value) && atoi(value) >= 0) {
+            options.task_options.max_length = atoi(value);
+        } else if (option_value(arg, "--count", value) && atoi(value) > 0) {
+            options.task_options.count = atoi(value);
+        } else if (option_value(arg, "--depth", value) && atoi(value) > 0) {
+            options.task_options.max_depth = atoi(value);
+        } else if (option_value(arg, "--seed", value)) {
+            options.task_options.seed = strtoull(value, nullptr, 10);
+        } else if (option_value(arg, "--format", value)) {
+            if (!output::parse_format(value, options.task_options.format)) {
+                cout << "Error: unknown format " << value << "\n";
+                return false;
+            }
+        } else if (option_value(arg, "--max-time", value) && atof(value) > 0) {
+            options.budget.max_ms = atof(value);
+        } else if (size_value(arg, "--max-rules", options.budget.max_rules) ||
+                   size_value(arg, "--max-bytes", options.budget.max_bytes) ||
+                   size_value(arg, "--chunk-bytes", options.chunk_bytes)) {
+            // Stored by size_value
+        } else if (option_value(arg, "--threads", value) && atoi(value) > 0) {
+            util::set_worker_threads(atoi(value));
+        } else if (strcmp(arg, "--ingest=parallel") == 0) {
+            options.parallel_ingest = true;
+        } else if (strcmp(arg, "--ingest=sequential") == 0) {
+            options.parallel_ingest = false;
+        } else if (strcmp(arg, "--reduce") == 0) {
+            options.reduce = true;
+        } else if (strcmp(arg, "--reduce=compare") == 0) {
+            options.reduce = true;
+            options.reduce_compare = true;
+        } else if (option_value(arg, "--pipeline", value)) {
+            string bad;
+            if (!pipeline::parse_stages(value, options.pipeline, bad)) {
+                cout << "Error: unknown pipeline stage " << bad << "\n";
+                return false;
+            }
+        } else if (strcmp(arg, "--dump-stages") == 0) {
+            options.dump_stages = true;
+        } else if (strcmp(arg, "--merge") == 0) {
+            options.task_options.merge = true;
+        } else if (strcmp(arg, "--merge=compare") == 0) {
+            options.task_options.merge = true;
+            options.task_options.merge_compare = true;
+        } else if (strcmp(arg, "--factor=conflicts") == 0) {
+            options.task_options.factor_conflicts = true;
+        } else if (strcmp(arg, "--factor=all") == 0) {
+            options.task_options.factor_conflicts = false;
+        } else if (option_value(arg, "--serve", value)) {
+            options.serve = value;
+        } else if (option_value(arg, "--cache", value) && atoi(value) > 0) {
+            options.cache_capacity = atoi(value);
+        } else if (option_value(arg, "--loadgen", value)) {
+            options.load.socket_path = value;
+        } else if (option_value(arg, "--grammar", value)) {
+            options.load.grammar_path = value;
+        } else if (option_value(arg, "--task", value)) {
+            options.load.task = atoi(value);
+        } else if (option_value(arg, "--clients", value) && atoi(value) > 0) {
+            options.load.clients = atoi(value);
+        } else if (option_value(arg, "--requests", value) && atoi(value) > 0) {
+            options.load.requests = atoi(value);
+        } else {
+            cout << "Error: unrecognized option " << arg << "\n";
+            return false;
+        }
+    }
+    if (task != 0 && options.task_options.format != OutputFormat::TEXT &&
+        !tasks::supports_format(task)) {
+        cout << "Error: --format is only supported for tasks 1-6, 10 and 16\n";
+        return false;
+    }
+    return true;
 }
 
 auto main(int argc, char *argv[]) -> int {
 
     int task = 0;
+    Options options;
 
     if (argc < 2) {
         cout << "Error: missing argument\n";
@@ -60,40 +224,60 @@ auto main(int argc, char *argv[]) -> int {
        and the first argument to your program is stored in argv[1]
      */
 
-    task = atoi(argv[1]);
-
-    Parser parser = Parser();
-    parser.parse_input();
-    auto grammar = parser.generate_grammar();
-
-    switch (task) {
-    case TASK_1:
-        Task1(grammar);
-        break;
-
-    case TASK_2:
-        Task2(grammar);
-        break;
+    bool has_task = strncmp(argv[1], "--", 2) != 0;
+    task = has_task ? atoi(argv[1]) : 0;
+    if (!parse_options(argc, argv, has_task ? 2 : 1, task, options)) {
+        return 1;
+    }
 
-    case TASK_3:
-        Task3(grammar);
-        break;
+    if (options.serve == "stdio") {
+        return server::serve_stdio(options.cache_capacity, options.budget);
+    }
+    if (!options.serve.empty()) {
+        return server::serve_socket(options.serve, options.cache_capacity,
+                                    options.budget);
+    }
+    if (!options.load.socket_path.empty()) {
+        return server::run_load_generator(options.load);
+    }
 
-    case TASK_4:
-        Task4(grammar);
-        break;
+    Grammar grammar;
+    try {
+        if (options.parallel_ingest) {
+            grammar = ingest::parse_stdin(options.chunk_bytes);
+        } else {
+            Parser parser = Parser();
+            parser.parse_input();
+            grammar = parser.generate_grammar();
+        }
+    } catch (const SyntaxError &error) {
+        cout << error.what() << "\n";
+        cerr << "Syntax error on line " << error.line << "\n";
+        return 1;
+    }
 
-    case TASK_5:
-        Task5(grammar);
-        break;
+    // Over budget, the run stops where it is with exit status 3
+    try {
+        budget::Scope scope(options.budget);
+        if (!options.pipeline.empty()) {
+            bool ok = pipeline::run_pipeline(std::move(grammar),
+                                             options.pipeline,
+                                             options.dump_stages,
+                                             options.task_options);
+            return ok ? 0 : 1;
+        }
 
-    case TASK_6:
-        Task6(grammar);
-        break;
+        if (options.reduce && (task == TASK_5 || task == TASK_6)) {
+            grammar = reduce_for_transform(grammar, task, options.task_options,
+                                           options.reduce_compare);
+        }
 
-    default:
-        cout << "Error: unrecognized task number " << task << "\n";
-        break;
+        if (!tasks::run_task(task, grammar, options.task_options)) {
+            cout << "Error: unrecognized task number " << task << "\n";
+        }
+    } catch (const BudgetExceeded &error) {
+        cout << "Error: " << error.what() << "\n";
+        return BUDGET_EXCEEDED_EXIT;
     }
     return 0;
 }
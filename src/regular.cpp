@@ -0,0 +1,511 @@
+#include "regular.h"
+#include "analysis.h"
+#include "budget.h"
+#include "ll1.h"
+#include "symbols.h"
+#include "types.h"
+#include "util.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// NFA of one component. State ACCEPT is the only accepting state.
+struct Nfa {
+    std::vector<std::vector<std::pair<int, int>>> edges; // (terminal, to)
+    std::vector<std::vector<int>> epsilon;
+
+    auto add_state() -> int {
+        edges.emplace_back();
+        epsilon.emplace_back();
+        return static_cast<int>(edges.size()) - 1;
+    }
+    auto size() const -> size_t { return edges.size(); }
+};
+
+const int ACCEPT = 0;
+
+// Subset construction output: moves sorted by terminal
+struct SparseDfa {
+    std::vector<std::vector<std::pair<int, int>>> moves;
+    std::vector<char> accepting;
+};
+
+// Copies dfa's states and transitions into nfa and returns the offset of
+// the copy
+auto embed(const Dfa &dfa, Nfa &nfa) -> int {
+    int offset = static_cast<int>(nfa.size());
+    for (int s = 0; s < dfa.num_states(); s++) {
+        nfa.add_state();
+    }
+    std::vector<int> read;
+    for (size_t t = 0; t < dfa.column.size(); t++) {
+        if (dfa.column[t] != 0) {
+            read.push_back(static_cast<int>(t));
+        }
+    }
+    for (int s = 0; s < dfa.num_states(); s++) {
+        for (int t : read) {
+            int to = dfa.step(s, t);
+            if (to != Dfa::DEAD) {
+                nfa.edges[offset + s].emplace_back(t, offset + to);
+            }
+        }
+    }
+    return offset;
+}
+
+// One chain of states per rule, from the member's start state to ACCEPT or
+// to the start state of the component nonterminal that ends the rule.
+// Returns false once the NFA grows past MAX_STATES.
+auto build_nfa(const RegularGrammar &regular, const std::vector<int> &members,
+               const std::vector<int> &member_index, Nfa &nfa,
+               std::vector<int> &start_of) -> bool {
+    const InternedGrammar &grammar = regular.grammar;
+    nfa.add_state(); // ACCEPT
+    for (size_t m = 0; m < members.size(); m++) {
+        start_of.push_back(nfa.add_state());
+    }
+
+    for (size_t m = 0; m < members.size(); m++) {
+        for (int rule : grammar.rules_of[members[m] - grammar.num_terms]) {
+            int current = start_of[m];
+            bool empty = false;
+            for (int symbol : grammar.rule_rhs[rule]) {
+                if (grammar.is_term(symbol)) {
+                    int to = nfa.add_state();
+                    nfa.edges[current].emplace_back(symbol, to);
+                    current = to;
+                    continue;
+                }
+                int index = member_index[symbol - grammar.num_terms];
+                if (index >= 0) { // last symbol, by the regularity check
+                    nfa.epsilon[current].push_back(start_of[index]);
+                    current = -1;
+                    break;
+                }
+                const Dfa &callee = *regular.dfa(symbol);
+                if (callee.start == Dfa::DEAD) {
+                    empty = true; // the rule derives no sentence
+                    break;
+                }
+                int offset = embed(callee, nfa);
+                nfa.epsilon[current].push_back(offset + callee.start);
+                int after = nfa.add_state();
+                for (int s = 0; s < callee.num_states(); s++) {
+                    if (callee.accepting[s] != 0) {
+                        nfa.epsilon[offset + s].push_back(after);
+                    }
+                }
+                current = after;
+                if (nfa.size() > regular::MAX_STATES) {
+                    return false;
+                }
+            }
+            if (!empty && current != -1) {
+                nfa.epsilon[current].push_back(ACCEPT);
+            }
+            if (nfa.size() > regular::MAX_STATES) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Sorted epsilon closure of states, using seen[s] == stamp as the mark.
+// states may repeat (several edges into one state); the result doesn't.
+auto closure(const Nfa &nfa, const std::vector<int> &states,
+             std::vector<int> &seen, int stamp) -> std::vector<int> {
+    std::vector<int> result;
+    std::vector<int> stack;
+    for (int s : states) {
+        if (seen[s] != stamp) {
+            seen[s] = stamp;
+            stack.push_back(s);
+        }
+    }
+    while (!stack.empty()) {
+        int s = stack.back();
+        stack.pop_back();
+        result.push_back(s);
+        for (int to : nfa.epsilon[s]) {
+            if (seen[to] != stamp) {
+                seen[to] = stamp;
+                stack.push_back(to);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Subset construction from one start state. Returns false past MAX_STATES.
+auto determinize(const Nfa &nfa, int start, int num_terms, SparseDfa &dfa)
+    -> bool {
+    std::vector<int> seen(nfa.size(), 0);
+    int stamp = 0;
+    std::map<std::vector<int>, int> ids;
+    std::vector<std::vector<int>> sets;
+    sets.push_back(closure(nfa, {start}, seen, ++stamp));
+    ids.emplace(sets[0], 0);
+
+    std::vector<std::vector<int>> targets(num_terms);
+    std::vector<int> touched;
+    for (size_t d = 0; d < sets.size(); d++) {
+        budget::poll("DFA state", d + 1, 0);
+        dfa.accepting.push_back(
+            std::binary_search(sets[d].begin(), sets[d].end(), ACCEPT) ? 1
+                                                                       : 0);
+        for (int s : sets[d]) {
+            for (const auto &edge : nfa.edges[s]) {
+                if (targets[edge.first].empty()) {
+                    touched.push_back(edge.first);
+                }
+                targets[edge.first].push_back(edge.second);
+            }
+        }
+        std::sort(touched.begin(), touched.end());
+
+        std::vector<std::pair<int, int>> moves;
+        for (int t : touched) {
+            std::vector<int> set = closure(nfa, targets[t], seen, ++stamp);
+            targets[t].clear();
+            auto found = ids.find(set);
+            if (found == ids.end()) {
+                found = ids.emplace(set, static_cast<int>(sets.size())).first;
+                sets.push_back(std::move(set));
+            }
+            moves.emplace_back(t, found->second);
+        }
+        touched.clear();
+        dfa.moves.push_back(std::move(moves));
+        if (sets.size() > regular::MAX_STATES) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Drops states that can't reach an accepting one, merges equivalent states
+// (Moore's partition refinement) and lays the result out densely, states
+// numbered breadth-first from the start and terminals grouped into columns
+auto minimize_dfa(const SparseDfa &sparse, int num_terms) -> Dfa {
+    const int num_states = static_cast<int>(sparse.accepting.size());
+
+    // Trim: backwards from the accepting states
+    std::vector<std::vector<int>> from(num_states);
+    for (int s = 0; s < num_states; s++) {
+        for (const auto &move : sparse.moves[s]) {
+            from[move.second].push_back(s);
+        }
+    }
+    std::vector<char> live(num_states, 0);
+    std::vector<int> queue;
+    for (int s = 0; s < num_states; s++) {
+        if (sparse.accepting[s] != 0) {
+            live[s] = 1;
+            queue.push_back(s);
+        }
+    }
+    for (size_t i = 0; i < queue.size(); i++) {
+        for (int s : from[queue[i]]) {
+            if (live[s] == 0) {
+                live[s] = 1;
+                queue.push_back(s);
+            }
+        }
+    }
+    Dfa dfa;
+    dfa.column.assign(num_terms, 0);
+    if (live[0] == 0) {
+        return dfa;
+    }
+
+    // Refine: a block splits when its states move to different blocks on
+    // some terminal, or only one of them can move. Blocks only split, so
+    // the first round that keeps their number is stable.
+    std::vector<int> block(num_states, -1);
+    for (int s = 0; s < num_states; s++) {
+        if (live[s] != 0) {
+            block[s] = sparse.accepting[s];
+        }
+    }
+    size_t num_blocks = 0;
+    while (true) {
+        std::map<std::vector<int>, int> classes;
+        std::vector<int> refined(num_states, -1);
+        for (int s = 0; s < num_states; s++) {
+            if (live[s] == 0) {
+                continue;
+            }
+            std::vector<int> signature{block[s]};
+            for (const auto &move : sparse.moves[s]) {
+                if (live[move.second] != 0) {
+                    signature.push_back(move.first);
+                    signature.push_back(block[move.second]);
+                }
+            }
+            refined[s] = classes
+                             .emplace(std::move(signature),
+                                      static_cast<int>(classes.size()))
+                             .first->second;
+        }
+        block = std::move(refined);
+        if (classes.size() == num_blocks) {
+            break;
+        }
+        num_blocks = classes.size();
+    }
+
+    // Number the blocks breadth-first from the start's
+    std::vector<int> representative(num_blocks, -1);
+    for (int s = num_states - 1; s >= 0; s--) {
+        if (live[s] != 0) {
+            representative[block[s]] = s;
+        }
+    }
+    std::vector<int> number(num_blocks, -1);
+    std::vector<int> order{block[0]};
+    number[block[0]] = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        for (const auto &move : sparse.moves[representative[order[i]]]) {
+            if (live[move.second] != 0 && number[block[move.second]] < 0) {
+                number[block[move.second]] =
+                    static_cast<int>(order.size());
+                order.push_back(block[move.second]);
+            }
+        }
+    }
+    const int size = static_cast<int>(order.size());
+
+    // Columns: terminals with the same target in every state share one
+    std::map<int, std::vector<int>> targets;
+    for (int q = 0; q < size; q++) {
+        for (const auto &move : sparse.moves[representative[order[q]]]) {
+            if (live[move.second] == 0) {
+                continue;
+            }
+            std::vector<int> &column = targets[move.first];
+            if (column.empty()) {
+                column.assign(size, Dfa::DEAD);
+            }
+            column[q] = number[block[move.second]];
+        }
+    }
+    std::map<std::vector<int>, int> columns;
+    for (const auto &target : targets) {
+        dfa.column[target.first] =
+            columns
+                .emplace(target.second, static_cast<int>(columns.size()) + 1)
+                .first->second;
+    }
+
+    dfa.start = 0;
+    dfa.width = static_cast<int>(columns.size()) + 1;
+    dfa.next.assign(static_cast<size_t>(size) * dfa.width, Dfa::DEAD);
+    for (const auto &column : columns) {
+        for (int q = 0; q < size; q++) {
+            dfa.next[q * dfa.width + column.second] = column.first[q];
+        }
+    }
+    dfa.accepting.resize(size);
+    for (int q = 0; q < size; q++) {
+        dfa.accepting[q] = sparse.accepting[representative[order[q]]];
+    }
+    return dfa;
+}
+
+// Right-linear over compiled callees: see regular::compile
+auto is_regular(const RegularGrammar &regular,
+                const std::vector<int> &members,
+                const std::vector<int> &member_index) -> bool {
+    const InternedGrammar &grammar = regular.grammar;
+    for (int nt : members) {
+        for (int rule : grammar.rules_of[nt - grammar.num_terms]) {
+            const std::vector<int> &rhs = grammar.rule_rhs[rule];
+            for (size_t i = 0; i < rhs.size(); i++) {
+                if (grammar.is_term(rhs[i])) {
+                    continue;
+                }
+                if (member_index[rhs[i] - grammar.num_terms] >= 0) {
+                    if (i + 1 != rhs.size()) {
+                        return false;
+                    }
+                } else if (regular.dfa(rhs[i]) == nullptr) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const int Dfa::DEAD;
+
+namespace regular {
+
+auto compile(const Grammar &grammar) -> RegularGrammar {
+    RegularGrammar regular;
+    regular.grammar = analysis::intern_grammar(grammar);
+    const InternedGrammar &interned = regular.grammar;
+    const int num_terms = interned.num_terms;
+    const int num_non_terms = interned.num_non_terms();
+    regular.dfa_of.assign(num_non_terms, -1);
+
+    std::vector<std::vector<int>> calls(num_non_terms);
+    for (size_t r = 0; r < interned.rule_rhs.size(); r++) {
+        for (int symbol : interned.rule_rhs[r]) {
+            if (!interned.is_term(symbol)) {
+                calls[interned.rule_lhs[r] - num_terms].push_back(symbol -
+                                                                  num_terms);
+            }
+        }
+    }
+
+    // Callees come first, so a component only calls compiled ones
+    std::vector<int> member_index(num_non_terms, -1);
+    auto components = graph::strongly_connected_components(calls);
+    size_t table = 0;
+    for (size_t c = 0; c < components.size(); c++) {
+        budget::check("regular component", c + 1, components.size());
+        if (table + num_terms > MAX_TABLE) {
+            break;
+        }
+        std::vector<int> members;
+        for (int nt : components[c]) {
+            members.push_back(nt + num_terms);
+        }
+        std::sort(members.begin(), members.end());
+        for (size_t m = 0; m < members.size(); m++) {
+            member_index[members[m] - num_terms] = static_cast<int>(m);
+        }
+
+        Nfa nfa;
+        std::vector<int> start_of;
+        std::vector<Dfa> dfas;
+        bool compiled =
+            is_regular(regular, members, member_index) &&
+            build_nfa(regular, members, member_index, nfa, start_of);
+        size_t added = 0;
+        for (size_t m = 0; compiled && m < members.size(); m++) {
+            SparseDfa sparse;
+            compiled = determinize(nfa, start_of[m], num_terms, sparse);
+            if (compiled) {
+                dfas.push_back(minimize_dfa(sparse, num_terms));
+                added += dfas.back().next.size() + dfas.back().column.size();
+                compiled = table + added <= MAX_TABLE;
+            }
+        }
+
+        for (int nt : members) {
+            member_index[nt - num_terms] = -1;
+        }
+        if (!compiled) {
+            continue;
+        }
+        table += added;
+        for (size_t m = 0; m < members.size(); m++) {
+            regular.dfa_of[members[m] - num_terms] =
+                static_cast<int>(regular.dfas.size());
+            regular.dfas.push_back(std::move(dfas[m]));
+        }
+        regular.components.push_back(std::move(members));
+    }
+    return regular;
+}
+
+auto print_regular_report(const Grammar &grammar, std::ostream &out) -> void {
+    auto start = std::chrono::steady_clock::now();
+    RegularGrammar regular = compile(grammar);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const InternedGrammar &interned = regular.grammar;
+
+    std::vector<std::string> not_regular;
+    size_t states = 0;
+    for (int nt = interned.num_terms; nt < interned.num_symbols(); nt++) {
+        const Dfa *dfa = regular.dfa(nt);
+        if (dfa == nullptr) {
+            not_regular.push_back(interned.names[nt]);
+            continue;
+        }
+        states += dfa->num_states();
+        out << "DFA(" << interned.names[nt] << ") = " << dfa->num_states()
+            << " states, " << dfa->width << " columns, accepting { ";
+        bool first = true;
+        for (int s = 0; s < dfa->num_states(); s++) {
+            if (dfa->accepting[s] != 0) {
+                out << (first ? "" : ", ") << s;
+                first = false;
+            }
+        }
+        out << " }\n";
+        for (int s = 0; s < dfa->num_states(); s++) {
+            for (int t = 0; t < interned.num_terms; t++) {
+                int to = dfa->step(s, t);
+                if (to != Dfa::DEAD) {
+                    out << "  " << s << " " << interned.names[t] << " -> "
+                        << to << "\n";
+                }
+            }
+        }
+    }
+    out << "Not regular = { " << util::join_vec_string(not_regular, ", ")
+        << " }\n";
+
+    std::cerr << "Compiled " << regular.dfas.size() << " of "
+              << interned.num_non_terms() << " nonterminals in "
+              << regular.components.size() << " components into " << states
+              << " DFA states (" << elapsed.count() << " ms)\n";
+}
+
+auto print_regular_parse(const Grammar &grammar, const std::string &path,
+                         std::ostream &out) -> void {
+    RegularGrammar regular = compile(grammar);
+    const InternedGrammar &interned = regular.grammar;
+    const Dfa *dfa = regular.dfa(interned.start());
+    if (dfa == nullptr) {
+        out << "Error: start symbol " << interned.names[interned.start()]
+            << " is not regular";
+        return;
+    }
+    std::ifstream in(path);
+    if (!in) {
+        out << "Error: cannot read sentences from " << path;
+        return;
+    }
+    auto sentences = ll1::read_sentences(in, interned);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> accepted(sentences.size());
+    util::parallel_for(sentences.size(), [&](size_t i) {
+        accepted[i] = dfa->accepts(sentences[i]) ? 1 : 0;
+    });
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    for (char result : accepted) {
+        out << (result != 0 ? "ACCEPT\n" : "REJECT\n");
+    }
+
+    size_t tokens = 0;
+    for (const auto &sentence : sentences) {
+        tokens += sentence.size();
+    }
+    double seconds = elapsed.count() / 1000;
+    std::cerr << "Parsed " << sentences.size() << " sentences in "
+              << elapsed.count() << " ms (" << tokens << " tokens, "
+              << static_cast<size_t>(seconds > 0 ? tokens / seconds : 0)
+              << " tokens/s, " << util::worker_threads() << " threads)\n";
+}
+
+} // namespace regular
@@ -0,0 +1,588 @@
+#include "server.h"
+#include "analysis.h"
+#include "budget.h"
+#include "parser.h"
+#include "tasks.h"
+#include "types.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+auto elapsed_ms(Clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+// Value below which p percent of the sorted samples fall
+auto percentile(const std::vector<double> &sorted, double p) -> double {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(p / 100 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+auto latency_summary(std::vector<double> samples) -> std::string {
+    std::sort(samples.begin(), samples.end());
+    std::ostringstream out;
+    out << "p50 = " << percentile(samples, 50) << " ms\n"
+        << "p99 = " << percentile(samples, 99) << " ms\n"
+        << "max = " << (samples.empty() ? 0 : samples.back()) << " ms";
+    return out.str();
+}
+
+// Latencies of the most recent requests in a ring of fixed size, so a
+// long-running server's statistics take constant memory
+class LatencyWindow {
+  public:
+    explicit LatencyWindow(size_t capacity) : capacity(capacity) {}
+
+    auto add(double ms) -> void {
+        if (samples.size() < capacity) {
+            samples.push_back(ms);
+        } else {
+            samples[total % capacity] = ms;
+        }
+        total++;
+    }
+
+    auto recent() const -> const std::vector<double> & { return samples; }
+    auto count() const -> size_t { return total; }
+
+  private:
+    size_t capacity;
+    std::vector<double> samples;
+    size_t total = 0;
+};
+
+auto parse_grammar(std::istream &in) -> Grammar {
+    Parser parser(in);
+    parser.parse_input();
+    return parser.generate_grammar();
+}
+
+// Rules written in grammar syntax, e.g. "A -> a B | *"
+auto parse_rules(const std::string &text) -> std::vector<Rule> {
+    std::istringstream in(text + " #");
+    return parse_grammar(in).rules;
+}
+
+struct CacheEntry {
+    std::mutex mutex;
+    Grammar grammar;
+    std::unordered_map<int, std::string> results;
+};
+
+/*
+ * LRU cache of parsed grammars keyed by path and content hash. A file is only
+ * re-read when its size or mtime changed since the last request for it.
+ */
+class GrammarCache {
+  public:
+    explicit GrammarCache(size_t capacity) : capacity(capacity) {}
+
+    auto get(const std::string &path) -> std::shared_ptr<CacheEntry> {
+        struct stat info {};
+        if (stat(path.c_str(), &info) != 0) {
+            throw std::runtime_error("cannot read " + path);
+        }
+        FileStamp stamp{info.st_mtim.tv_sec, info.st_mtim.tv_nsec,
+                        info.st_size, 0};
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto known = stamps.find(path);
+            if (known != stamps.end() && known->second.same_file(stamp)) {
+                auto entry = lookup(key_of(path, known->second.hash));
+                if (entry) {
+                    return entry;
+                }
+            }
+        }
+
+        std::ifstream file(path, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+        stamp.hash = std::hash<std::string>()(content);
+        std::string key = key_of(path, stamp.hash);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto entry = lookup(key);
+            if (entry) {
+                stamps[path] = stamp;
+                return entry;
+            }
+        }
+
+        // Parse outside the lock so misses on different files overlap
+        auto entry = std::make_shared<CacheEntry>();
+        std::istringstream in(content);
+        entry->grammar = parse_grammar(in);
+
+        // Only a file that parsed gets a stamp, so stamps never outnumber
+        // entries
+        std::lock_guard<std::mutex> lock(mutex);
+        misses++;
+        stamps[path] = stamp;
+        auto raced = entries.find(key);
+        if (raced != entries.end()) {
+            return raced->second.first;
+        }
+        lru.push_front(key);
+        entries.emplace(key, std::make_pair(entry, lru.begin()));
+        while (entries.size() > capacity) {
+            evict(lru.back());
+            lru.pop_back();
+        }
+        return entry;
+    }
+
+    auto counters() -> std::pair<size_t, size_t> {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::make_pair(hits, misses);
+    }
+
+  private:
+    struct FileStamp {
+        time_t mtime_sec;
+        long mtime_nsec;
+        off_t size;
+        size_t hash;
+
+        auto same_file(const FileStamp &other) const -> bool {
+            return mtime_sec == other.mtime_sec &&
+                   mtime_nsec == other.mtime_nsec && size == other.size;
+        }
+    };
+
+    static auto key_of(const std::string &path, size_t hash) -> std::string {
+        return path + "\n" + std::to_string(hash);
+    }
+
+    // Caller holds the lock. The file's stamp goes with the entry unless it
+    // already points at newer content, which has an entry of its own.
+    auto evict(const std::string &key) -> void {
+        entries.erase(key);
+        auto stamp = stamps.find(key.substr(0, key.rfind('\n')));
+        if (stamp != stamps.end() &&
+            key_of(stamp->first, stamp->second.hash) == key) {
+            stamps.erase(stamp);
+        }
+    }
+
+    // Caller holds the lock. Marks the entry most recently used.
+    auto lookup(const std::string &key) -> std::shared_ptr<CacheEntry> {
+        auto found = entries.find(key);
+        if (found == entries.end()) {
+            return nullptr;
+        }
+        lru.splice(lru.begin(), lru, found->second.second);
+        hits++;
+        return found->second.first;
+    }
+
+    size_t capacity;
+    std::mutex mutex;
+    std::list<std::string> lru;
+    std::unordered_map<std::string,
+                       std::pair<std::shared_ptr<CacheEntry>,
+                                 std::list<std::string>::iterator>>
+        entries;
+    std::unordered_map<std::string, FileStamp> stamps;
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+class Server {
+  public:
+    Server(size_t cache_capacity, const Budget &budget)
+        : cache(cache_capacity), run_budget(budget),
+          latencies(server::LATENCY_WINDOW) {}
+
+    // Returns the full response for one request line
+    auto handle(const std::string &line, bool &shutdown) -> std::string {
+        auto start = Clock::now();
+        std::string response;
+        try {
+            response = "OK ";
+            std::string payload = dispatch(line, shutdown);
+            response += std::to_string(payload.size()) + "\n" + payload;
+        } catch (const std::exception &error) {
+            response = std::string("ERR ") + error.what() + "\n";
+        }
+
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        latencies.add(elapsed_ms(start));
+        return response;
+    }
+
+  private:
+    auto dispatch(const std::string &line, bool &shutdown) -> std::string {
+        std::istringstream request(line);
+        std::string command;
+        request >> command;
+
+        if (command == "TASK") {
+            int task = 0;
+            std::string path;
+            if (!(request >> task >> path)) {
+                throw std::runtime_error("usage: TASK <n> <path>");
+            }
+            return run_task(task, path);
+        }
+        if (command == "ADD" || command == "REMOVE") {
+            std::string path;
+            std::string rules;
+            request >> path;
+            std::getline(request, rules);
+            edit(path, parse_rules(rules), command == "ADD");
+            return "";
+        }
+        if (command == "STATS") {
+            return stats();
+        }
+        if (command == "SHUTDOWN") {
+            shutdown = true;
+            return "";
+        }
+        throw std::runtime_error("unknown command " + command);
+    }
+
+    auto run_task(int task, const std::string &path) -> std::string {
+        auto entry = cache.get(path);
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        auto cached = entry->results.find(task);
+        if (cached != entry->results.end()) {
+            return cached->second;
+        }
+
+        // A run over budget fails this request only, and is not cached
+        std::ostringstream out;
+        budget::Scope scope(run_budget);
+        if (!tasks::run_task(task, entry->grammar, TaskOptions(), out)) {
+            throw std::runtime_error("unrecognized task number " +
+                                     std::to_string(task));
+        }
+
+        // Tasks report failures as an "Error: " line first; neither is
+        // cached, and only that line fits in an ERR response
+        std::string result = out.str();
+        static const std::string error = "Error: ";
+        if (result.compare(0, error.size(), error) == 0) {
+            throw std::runtime_error(
+                result.substr(error.size(), result.find('\n') - error.size()));
+        }
+        return entry->results.emplace(task, std::move(result)).first->second;
+    }
+
+    // Edits apply to the cached grammar of the file's current content
+    auto edit(const std::string &path, const std::vector<Rule> &rules,
+              bool add) -> void {
+        auto entry = cache.get(path);
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        std::vector<Rule> edited = entry->grammar.rules;
+        if (add) {
+            edited.insert(edited.end(), rules.begin(), rules.end());
+        } else {
+            std::unordered_set<Rule, RuleHasher> removed(rules.begin(),
+                                                         rules.end());
+            edited.erase(std::remove_if(edited.begin(), edited.end(),
+                                        [&removed](const Rule &rule) {
+                                            return removed.count(rule) == 1;
+                                        }),
+                         edited.end());
+        }
+        if (edited.empty()) {
+            throw std::runtime_error("grammar would have no rules");
+        }
+        entry->grammar = analysis::grammar_from_rules(std::move(edited));
+        entry->results.clear();
+    }
+
+    auto stats() -> std::string {
+        auto counters = cache.counters();
+        std::vector<double> samples;
+        size_t requests = 0;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            samples = latencies.recent();
+            requests = latencies.count();
+        }
+        std::ostringstream out;
+        out << "requests = " << requests << "\n"
+            << "cache hits = " << counters.first << "\n"
+            << "cache misses = " << counters.second << "\n"
+            << latency_summary(samples);
+        return out.str();
+    }
+
+    GrammarCache cache;
+    Budget run_budget;
+    std::mutex stats_mutex;
+    LatencyWindow latencies;
+};
+
+auto write_all(int fd, const std::string &data) -> bool {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent,
+                         MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Buffered reads of lines and fixed-size payloads from a socket
+class SocketReader {
+  public:
+    explicit SocketReader(int fd) : fd(fd) {}
+
+    auto read_line(std::string &line) -> bool {
+        size_t newline = 0;
+        while ((newline = buffer.find('\n')) == std::string::npos) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        line.assign(buffer, 0, newline);
+        buffer.erase(0, newline + 1);
+        return true;
+    }
+
+    auto read_bytes(size_t count, std::string &bytes) -> bool {
+        while (buffer.size() < count) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        bytes.assign(buffer, 0, count);
+        buffer.erase(0, count);
+        return true;
+    }
+
+  private:
+    auto fill() -> bool {
+        char chunk[4096];
+        ssize_t n = 0;
+        do {
+            n = recv(fd, chunk, sizeof(chunk), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd;
+    std::string buffer;
+};
+
+auto socket_address(const std::string &path, sockaddr_un &address) -> bool {
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: socket path too long: " << path << "\n";
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return true;
+}
+
+} // namespace
+
+namespace server {
+
+auto serve_socket(const std::string &socket_path, size_t cache_capacity,
+                  const Budget &budget) -> int {
+    sockaddr_un address{};
+    if (!socket_address(socket_path, address)) {
+        return 1;
+    }
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if (listen_fd < 0 ||
+        bind(listen_fd, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) != 0 ||
+        listen(listen_fd, SOMAXCONN) != 0) {
+        std::cerr << "Error: cannot listen on " << socket_path << ": "
+                  << strerror(errno) << "\n";
+        return 1;
+    }
+
+    Server server(cache_capacity, budget);
+    std::atomic<bool> stopping(false);
+    std::mutex clients_mutex;
+    std::unordered_set<int> clients;
+
+    // Finished sessions are joined whenever a new client connects
+    struct Session {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::list<Session> sessions;
+
+    while (true) {
+        int client = accept(listen_fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR && !stopping) {
+                continue;
+            }
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            clients.insert(client);
+        }
+
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            if (*it->done) {
+                it->thread.join();
+                it = sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // One thread per connection; a connection sends requests in order
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::thread session([&, client, done]() {
+            SocketReader reader(client);
+            std::string line;
+            bool shutdown = false;
+            while (!shutdown && reader.read_line(line)) {
+                if (!write_all(client, server.handle(line, shutdown))) {
+                    break;
+                }
+            }
+            if (shutdown) {
+                stopping = true;
+                ::shutdown(listen_fd, SHUT_RDWR);
+            }
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            clients.erase(client);
+            close(client);
+            *done = true;
+        });
+        sessions.push_back(Session{std::move(session), done});
+    }
+
+    // Wake every session still blocked on a read, then wait for them
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        for (int client : clients) {
+            ::shutdown(client, SHUT_RDWR);
+        }
+    }
+    for (Session &session : sessions) {
+        session.thread.join();
+    }
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    return stopping ? 0 : 1;
+}
+
+auto serve_stdio(size_t cache_capacity, const Budget &budget) -> int {
+    Server server(cache_capacity, budget);
+    std::string line;
+    bool shutdown = false;
+    while (!shutdown && std::getline(std::cin, line)) {
+        std::cout << server.handle(line, shutdown) << std::flush;
+    }
+    return 0;
+}
+
+auto run_load_generator(const LoadOptions &options) -> int {
+    sockaddr_un address{};
+    if (!socket_address(options.socket_path, address)) {
+        return 1;
+    }
+
+    const std::string request = "TASK " + std::to_string(options.task) + " " +
+                                options.grammar_path + "\n";
+    std::vector<std::vector<double>> latencies(options.clients);
+    std::atomic<int> errors(0);
+
+    auto start = Clock::now();
+    std::vector<std::thread> clients;
+    for (int c = 0; c < options.clients; c++) {
+        clients.emplace_back([&, c]() {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address),
+                                  sizeof(address)) != 0) {
+                errors += options.requests;
+                if (fd >= 0) {
+                    close(fd);
+                }
+                return;
+            }
+            SocketReader reader(fd);
+            std::string header;
+            std::string payload;
+            for (int r = 0; r < options.requests; r++) {
+                auto sent = Clock::now();
+                if (!write_all(fd, request) || !reader.read_line(header)) {
+                    errors += options.requests - r;
+                    break;
+                }
+                if (header.compare(0, 3, "OK ") != 0 ||
+                    !reader.read_bytes(std::stoul(header.substr(3)),
+                                       payload)) {
+                    errors++;
+                    continue;
+                }
+                latencies[c].push_back(elapsed_ms(sent));
+            }
+            close(fd);
+        });
+    }
+    for (std::thread &client : clients) {
+        client.join();
+    }
+    double total_ms = elapsed_ms(start);
+
+    std::vector<double> samples;
+    for (const std::vector<double> &client : latencies) {
+        samples.insert(samples.end(), client.begin(), client.end());
+    }
+    std::cout << "clients = " << options.clients << "\n"
+              << "requests = " << samples.size() << "\n"
+              << "errors = " << errors << "\n"
+              << "throughput = " << samples.size() / (total_ms / 1000)
+              << " req/s\n"
+              << latency_summary(samples) << "\n";
+    return errors == 0 ? 0 : 1;
+}
+
+} // namespace server
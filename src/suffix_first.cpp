@@ -0,0 +1,127 @@
+#include "suffix_first.h"
+#include "analysis.h"
+#include "symbols.h"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// Trie edges: (tail node, prepended symbol) -> node
+auto edge_key(int tail, int symbol) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(tail)) << 32) |
+           static_cast<uint32_t>(symbol);
+}
+
+class SuffixBuilder {
+  public:
+    explicit SuffixBuilder(SuffixFirstTable &table) : table(table) {
+        table.nodes.emplace_back(); // the empty suffix
+    }
+
+    // Node for (symbol tail), created on first use. symbol_nodes must hold
+    // symbol's own node unless tail is the empty suffix.
+    auto prepend(int symbol, int tail, const std::vector<int> &symbol_first,
+                 bool symbol_nullable) -> int {
+        auto inserted = edges.emplace(edge_key(tail, symbol), 0);
+        if (!inserted.second) {
+            return inserted.first->second;
+        }
+
+        SuffixFirst node;
+        const SuffixFirst rest = table.nodes[tail];
+        if (tail == 0) {
+            // FIRST(X) itself
+            node.begin = static_cast<uint32_t>(table.terms.size());
+            table.terms.insert(table.terms.end(), symbol_first.begin(),
+                               symbol_first.end());
+            node.end = static_cast<uint32_t>(table.terms.size());
+            node.nullable = symbol_nullable;
+        } else {
+            const SuffixFirst own = table.of_symbol(symbol);
+            node.nullable = own.nullable && rest.nullable;
+            if (!own.nullable || rest.size() == 0) {
+                node.begin = own.begin;
+                node.end = own.end;
+            } else if (std::includes(table.first_begin(rest),
+                                     table.first_end(rest),
+                                     table.first_begin(own),
+                                     table.first_end(own))) {
+                node.begin = rest.begin;
+                node.end = rest.end;
+            } else {
+                // Copy both operands out first: appending may reallocate
+                std::vector<int> merged;
+                std::set_union(table.first_begin(own), table.first_end(own),
+                               table.first_begin(rest), table.first_end(rest),
+                               std::back_inserter(merged));
+                node.begin = static_cast<uint32_t>(table.terms.size());
+                table.terms.insert(table.terms.end(), merged.begin(),
+                                   merged.end());
+                node.end = static_cast<uint32_t>(table.terms.size());
+            }
+        }
+
+        int id = static_cast<int>(table.nodes.size());
+        table.nodes.push_back(node);
+        inserted.first->second = id;
+        return id;
+    }
+
+  private:
+    SuffixFirstTable &table;
+    std::unordered_map<uint64_t, int> edges;
+};
+
+} // namespace
+
+namespace analysis {
+
+auto build_suffix_first(const InternedGrammar &grammar, const SetMap &first,
+                        const std::unordered_set<std::string> &nullable)
+    -> SuffixFirstTable {
+    SuffixFirstTable table;
+    SuffixBuilder builder(table);
+
+    // One-symbol suffixes first, so longer ones can share their slices
+    table.symbol_nodes.resize(grammar.num_symbols());
+    std::vector<int> symbol_first;
+    for (int symbol = 0; symbol < grammar.num_symbols(); symbol++) {
+        symbol_first.clear();
+        const std::string &name = grammar.names[symbol];
+        auto found = first.find(name);
+        if (found != first.end()) {
+            for (const std::string &term : found->second) {
+                symbol_first.push_back(grammar.ids.at(term));
+            }
+        }
+        std::sort(symbol_first.begin(), symbol_first.end());
+        table.symbol_nodes[symbol] = builder.prepend(
+            symbol, 0, symbol_first, nullable.count(name) == 1);
+    }
+
+    // Every rule right-to-left
+    size_t num_rules = grammar.rule_rhs.size();
+    table.rule_start.reserve(num_rules);
+    for (size_t r = 0; r < num_rules; r++) {
+        const std::vector<int> &rhs = grammar.rule_rhs[r];
+        size_t start = table.positions.size();
+        table.rule_start.push_back(start);
+        table.positions.resize(start + rhs.size() + 1);
+
+        int node = 0;
+        table.positions[start + rhs.size()] = node;
+        for (size_t i = rhs.size(); i-- > 0;) {
+            node = builder.prepend(rhs[i], node, symbol_first, false);
+            table.positions[start + i] = node;
+        }
+    }
+
+    return table;
+}
+
+} // namespace analysis
@@ -0,0 +1,107 @@
+#include "symbols.h"
+#include "types.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace analysis {
+
+auto intern_grammar(const Grammar &grammar) -> InternedGrammar {
+    InternedGrammar interned;
+    interned.num_terms = static_cast<int>(grammar.term_order.size());
+
+    for (const std::string &term : grammar.term_order) {
+        interned.ids.emplace(term, interned.num_symbols());
+        interned.names.push_back(term);
+    }
+    for (const std::string &non_term : grammar.non_term_order) {
+        interned.ids.emplace(non_term, interned.num_symbols());
+        interned.names.push_back(non_term);
+    }
+
+    interned.rules_of.resize(interned.num_non_terms());
+    interned.rule_lhs.reserve(grammar.rules.size());
+    interned.rule_rhs.reserve(grammar.rules.size());
+    for (const Rule &rule : grammar.rules) {
+        int lhs = interned.ids.at(rule.lhs);
+        std::vector<int> rhs;
+        rhs.reserve(rule.rhs.size());
+        for (const std::string &symbol : rule.rhs) {
+            rhs.push_back(interned.ids.at(symbol));
+        }
+        interned.rules_of[lhs - interned.num_terms].push_back(
+            static_cast<int>(interned.rule_lhs.size()));
+        interned.rule_lhs.push_back(lhs);
+        interned.rule_rhs.push_back(std::move(rhs));
+    }
+
+    return interned;
+}
+
+} // namespace analysis
+
+namespace graph {
+
+auto strongly_connected_components(const std::vector<std::vector<int>> &edges)
+    -> std::vector<std::vector<int>> {
+    const int unvisited = -1;
+    const int num_nodes = static_cast<int>(edges.size());
+
+    std::vector<int> index(num_nodes, unvisited);
+    std::vector<int> low_link(num_nodes, 0);
+    std::vector<bool> on_stack(num_nodes, false);
+    std::vector<int> stack;
+    std::vector<std::vector<int>> components;
+    int next_index = 0;
+
+    // Explicit call stack of (node, next edge to visit)
+    std::vector<std::pair<int, size_t>> calls;
+    for (int root = 0; root < num_nodes; root++) {
+        if (index[root] != unvisited) {
+            continue;
+        }
+        calls.emplace_back(root, 0);
+        while (!calls.empty()) {
+            int node = calls.back().first;
+            size_t &edge = calls.back().second;
+
+            if (edge == 0 && index[node] == unvisited) {
+                index[node] = low_link[node] = next_index++;
+                stack.push_back(node);
+                on_stack[node] = true;
+            }
+
+            if (edge < edges[node].size()) {
+                int next = edges[node][edge++];
+                if (index[next] == unvisited) {
+                    calls.emplace_back(next, 0);
+                } else if (on_stack[next]) {
+                    low_link[node] = std::min(low_link[node], index[next]);
+                }
+                continue;
+            }
+
+            // All edges visited: pop the frame and close the component
+            calls.pop_back();
+            if (!calls.empty()) {
+                int parent = calls.back().first;
+                low_link[parent] = std::min(low_link[parent], low_link[node]);
+            }
+            if (low_link[node] != index[node]) {
+                continue;
+            }
+            std::vector<int> component;
+            int member = 0;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                on_stack[member] = false;
+                component.push_back(member);
+            } while (member != node);
+            components.push_back(std::move(component));
+        }
+    }
+    return components;
+}
+
+} // namespace graph
@@ -0,0 +1,281 @@
+#include "tasks.h"
+#include "analysis.h"
+#include "consts.h"
+#include "earley.h"
+#include "generator.h"
+#include "lalr.h"
+#include "ll1.h"
+#include "lookahead.h"
+#include "minimize.h"
+#include "output.h"
+#include "regular.h"
+#include "types.h"
+#include "util.h"
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Task 1:
+ * Printing the terminals, then nonterminals of grammar in appearing order
+ * output is one line, and all names are space delineated
+ */
+void Task1(const Grammar &grammar, OutputFormat format, ostream &out) {
+    if (format != OutputFormat::TEXT) {
+        output::write_symbols(grammar, format, out);
+        return;
+    }
+    std::string terms = util::join_vec_string(grammar.term_order, " ");
+    std::string non_terms = util::join_vec_string(grammar.non_term_order, " ");
+    out << terms << " " << non_terms;
+}
+
+/*
+ * Task 2:
+ * Print out nullable set of the grammar in specified format.
+ */
+void Task2(const Grammar &grammar, OutputFormat format, ostream &out) {
+    if (format != OutputFormat::TEXT) {
+        output::write_nullable(grammar, format, out);
+        return;
+    }
+    analysis::print_nullable_set(grammar, out);
+}
+
+// Task 3: FIRST sets
+void Task3(const Grammar &grammar, OutputFormat format, ostream &out) {
+    if (format != OutputFormat::TEXT) {
+        output::write_set_map(analysis::calc_first(grammar), grammar, "FIRST",
+                              format, out);
+        return;
+    }
+    analysis::print_first_sets(grammar, out);
+}
+
+// Task 4: FOLLOW sets
+void Task4(const Grammar &grammar, OutputFormat format, ostream &out) {
+    if (format != OutputFormat::TEXT) {
+        output::write_set_map(analysis::calc_follow(grammar), grammar,
+                              "FOLLOW", format, out);
+        return;
+    }
+    analysis::print_follow_sets(grammar, out);
+}
+
+// Tasks 5 and 6 with --merge: the transformed rules, minimized
+void print_merged(vector<Rule> rules, const TaskOptions &options,
+                  ostream &out) {
+    Grammar merged =
+        minimize::merge_transformed(std::move(rules), options.merge_compare);
+    if (options.format != OutputFormat::TEXT) {
+        output::write_rules(merged.rules, options.format, out);
+        return;
+    }
+    analysis::print_rules(merged.rules, out);
+}
+
+// Task 5: left factoring, of every shared prefix or with --factor=conflicts
+// only where predictions clash
+void Task5(const Grammar &grammar, const TaskOptions &options, ostream &out) {
+    auto factor = [&]() {
+        return options.factor_conflicts
+                   ? analysis::calc_left_factored_conflicts(grammar)
+                   : analysis::calc_left_factored(grammar);
+    };
+    if (options.merge) {
+        print_merged(factor(), options, out);
+        return;
+    }
+    if (options.format != OutputFormat::TEXT) {
+        auto rules = factor();
+        output::write_rules(rules, options.format, out);
+        return;
+    }
+    if (options.factor_conflicts) {
+        auto rules = factor();
+        analysis::print_rules(rules, out);
+        return;
+    }
+    analysis::print_left_factored_grammar(grammar, out);
+}
+
+// Task 6: eliminate left recursion
+void Task6(const Grammar &grammar, const TaskOptions &options, ostream &out) {
+    if (options.merge) {
+        print_merged(analysis::eliminate_left_recursion(grammar), options, out);
+        return;
+    }
+    if (options.format != OutputFormat::TEXT) {
+        auto rules = analysis::eliminate_left_recursion(grammar);
+        output::write_rules(rules, options.format, out);
+        return;
+    }
+    analysis::print_grammar_without_left_recursion(grammar, out);
+}
+
+// Task 7: FIRST_k sets
+void Task7(const Grammar &grammar, int k, ostream &out) {
+    analysis::print_first_k_sets(grammar, k, out);
+}
+
+// Task 8: FOLLOW_k sets
+void Task8(const Grammar &grammar, int k, ostream &out) {
+    analysis::print_follow_k_sets(grammar, k, out);
+}
+
+// Task 9: LALR(1) automaton and its conflicts
+void Task9(const Grammar &grammar, ostream &out) {
+    analysis::print_lalr_report(grammar, out);
+}
+
+// Task 10: remove useless symbols
+void Task10(const Grammar &grammar, OutputFormat format, ostream &out) {
+    if (format != OutputFormat::TEXT) {
+        auto rules = analysis::remove_useless_symbols(grammar).rules;
+        output::write_rules(rules, format, out);
+        return;
+    }
+    analysis::print_reduced_grammar(grammar, out);
+}
+
+// Task 11: recursive-descent parser source for an LL(1) grammar
+void Task11(const Grammar &grammar, ostream &out) {
+    ll1::print_generated_parser(grammar, out);
+}
+
+// Task 12: table-driven LL(1) parse of the sentences in a file
+void Task12(const Grammar &grammar, const string &path, ostream &out) {
+    ll1::print_table_parse(grammar, path, out);
+}
+
+// Task 13: shortest sentences of the grammar
+void Task13(const Grammar &grammar, size_t max_length, size_t count,
+            ostream &out) {
+    ll1::print_enumerated_sentences(grammar, max_length, count, out);
+}
+
+// Task 14: general (Earley) parse of the sentences in a file
+void Task14(const Grammar &grammar, const string &path, ostream &out) {
+    earley::print_general_parse(grammar, path, out);
+}
+
+// Task 15: random sentences for load-testing parsers
+void Task15(const Grammar &grammar, const TaskOptions &options, ostream &out) {
+    GeneratorOptions generator_options;
+    generator_options.max_length = options.max_length;
+    generator_options.max_depth = options.max_depth;
+    generator_options.count = options.count;
+    generator_options.seed = options.seed;
+    generator::print_random_sentences(grammar, generator_options, out);
+}
+
+// Task 16: merge equivalent nonterminals
+void Task16(const Grammar &grammar, OutputFormat format, ostream &out) {
+    if (format != OutputFormat::TEXT) {
+        auto rules = minimize::merge_equivalent_non_terms(grammar).rules;
+        output::write_rules(rules, format, out);
+        return;
+    }
+    minimize::print_merged_grammar(grammar, out);
+}
+
+// Task 17: regular sub-grammars compiled into DFAs; with --sentences, the
+// start symbol's DFA recognizes them
+void Task17(const Grammar &grammar, const string &path, ostream &out) {
+    if (path.empty()) {
+        regular::print_regular_report(grammar, out);
+        return;
+    }
+    regular::print_regular_parse(grammar, path, out);
+}
+
+namespace tasks {
+
+auto supports_format(int task) -> bool {
+    return task == TASK_1 || task == TASK_2 || task == TASK_3 ||
+           task == TASK_4 || task == TASK_5 || task == TASK_6 ||
+           task == TASK_10 || task == TASK_16;
+}
+
+auto run_task(int task, const Grammar &grammar, const TaskOptions &options,
+              ostream &out) -> bool {
+    const OutputFormat format = options.format;
+    switch (task) {
+    case TASK_1:
+        Task1(grammar, format, out);
+        break;
+
+    case TASK_2:
+        Task2(grammar, format, out);
+        break;
+
+    case TASK_3:
+        Task3(grammar, format, out);
+        break;
+
+    case TASK_4:
+        Task4(grammar, format, out);
+        break;
+
+    case TASK_5:
+        Task5(grammar, options, out);
+        break;
+
+    case TASK_6:
+        Task6(grammar, options, out);
+        break;
+
+    case TASK_7:
+        Task7(grammar, options.k, out);
+        break;
+
+    case TASK_8:
+        Task8(grammar, options.k, out);
+        break;
+
+    case TASK_9:
+        Task9(grammar, out);
+        break;
+
+    case TASK_10:
+        Task10(grammar, format, out);
+        break;
+
+    case TASK_11:
+        Task11(grammar, out);
+        break;
+
+    case TASK_12:
+        Task12(grammar, options.sentences_path, out);
+        break;
+
+    case TASK_13:
+        Task13(grammar, options.max_length, options.count, out);
+        break;
+
+    case TASK_14:
+        Task14(grammar, options.sentences_path, out);
+        break;
+
+    case TASK_15:
+        Task15(grammar, options, out);
+        break;
+
+    case TASK_16:
+        Task16(grammar, format, out);
+        break;
+
+    case TASK_17:
+        Task17(grammar, options.sentences_path, out);
+        break;
+
+    default:
+        return false;
+    }
+    return true;
+}
+
+} // namespace tasks
@@ -1,13 +1,21 @@
 #include "util.h"
 #include "lexer.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 
 namespace parser_util {
 auto starts_rule(const Token &tok) -> bool { return tok.token_type == ID; }
 auto is_follow_id_list(const Token &tok) -> bool {
-    return (tok.token_type == OR || tok.token_type == STAR);
+    return (tok.token_type == OR || tok.token_type == STAR ||
+            tok.token_type == RPAREN || tok.token_type == RBRAC ||
+            tok.token_type == RBRACE);
+}
+auto starts_item(const Token &tok) -> bool {
+    return (tok.token_type == ID || tok.token_type == LPAREN ||
+            tok.token_type == LBRAC || tok.token_type == LBRACE);
 }
 } // namespace parser_util
 
@@ -25,25 +33,72 @@ auto join_vec_string(const std::vector<std::string> &vec,
     return oss.str();
 }
 
+auto rank_index(const std::vector<std::string> &order) -> RankIndex {
+    RankIndex rank;
+    rank.reserve(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        rank.emplace(order[i], i);
+    }
+    return rank;
+}
+
 auto generate_ordered_vec(const std::unordered_set<std::string> &set,
                           const std::vector<std::string> &order)
     -> std::vector<std::string> {
     std::vector<std::string> ordered_set;
-
-    // Add dollar sign first even though it is not in the order of terms
-    if (set.count("$") == 1) {
-        ordered_set.emplace_back("$");
+    for (const std::string *item :
+         generate_ordered_vec(set, rank_index(order))) {
+        ordered_set.push_back(*item);
     }
+    return ordered_set;
+}
 
-    for (const std::string &item : order) {
-        if (set.count(item) == 1) {
-            ordered_set.push_back(item);
+// Sorts the set's items by rank instead of scanning the whole order, so the
+// cost is O(|set| log |set|) however long the order is. Items without a rank
+// are dropped, except $ which always goes first.
+auto generate_ordered_vec(const std::unordered_set<std::string> &set,
+                          const RankIndex &rank)
+    -> std::vector<const std::string *> {
+    std::vector<std::pair<size_t, const std::string *>> ranked;
+    ranked.reserve(set.size());
+    bool has_dollar = false;
+    for (const std::string &item : set) {
+        if (item == "$") {
+            has_dollar = true;
+            continue;
+        }
+        auto found = rank.find(item);
+        if (found != rank.end()) {
+            ranked.emplace_back(found->second, &item);
         }
     }
+    std::sort(ranked.begin(), ranked.end());
 
+    std::vector<const std::string *> ordered_set;
+    ordered_set.reserve(ranked.size() + 1);
+    if (has_dollar) {
+        ordered_set.push_back(&*set.find("$"));
+    }
+    for (const auto &item : ranked) {
+        ordered_set.push_back(item.second);
+    }
     return ordered_set;
 }
 
+static size_t configured_threads = 0;
+
+auto set_worker_threads(size_t threads) -> void {
+    configured_threads = threads;
+}
+
+auto worker_threads() -> size_t {
+    if (configured_threads != 0) {
+        return configured_threads;
+    }
+    size_t hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : hardware;
+}
+
 auto print_unordered_set(const std::unordered_set<std::string> &set) -> void {
     std::cout << "{ ";
     for (const auto &elem : set) {
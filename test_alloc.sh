@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# Checks that parsing, the analyses of Tasks 2-4, the rule map and the
+# transforms of Tasks 5 and 6 allocate in proportion to the grammar and
+# their results, never per fixpoint pass, and copy no name more than once:
+# tests/alloc_count.cpp counts calls to operator new while each runs and
+# prints, with short and with lengthened names. A chain grammar needing one
+# pass per rule and a grammar of few symbols in long rules are checked
+# along with every grammar under tests/ and any given on the command line.
+#
+# Usage: ./test_alloc.sh [grammar...]
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+
+mkdir -p ./output
+
+${CXX} -std=c++11 -O2 -I./include tests/alloc_count.cpp \
+    $(ls src/*.cpp | grep -v project2.cpp) -pthread \
+    -o ./output/alloc_count || exit 1
+
+# A(i) -> A(i+1) t(i), listed so FIRST moves one rule further per pass
+for i in $(seq 1 500); do
+    echo "A${i} -> A$((i+1)) t${i} *"
+done > ./output/chain.txt
+echo "A501 -> t501 *" >> ./output/chain.txt
+echo "#" >> ./output/chain.txt
+
+# Ten nonterminals with twenty 20-symbol rules each, sharing prefixes so
+# Task 5 has something to factor: a name copied per occurrence dwarfs the
+# allowance per symbol
+for i in $(seq 11 20); do
+    for j in $(seq 1 20); do
+        rhs="t$(( (i + j) % 3 ))"
+        for k in $(seq 1 19); do
+            if [ $(( (i * j + k) % 3 )) -eq 0 ]; then
+                rhs="${rhs} N$(( (i + j + k) % 10 + 11 ))"
+            else
+                rhs="${rhs} t$(( (i * k + j) % 10 ))"
+            fi
+        done
+        echo "N${i} -> ${rhs} *"
+    done
+done > ./output/wide.txt
+echo "N20 -> *" >> ./output/wide.txt
+echo "#" >> ./output/wide.txt
+
+let count=0
+let all=0
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort) ./output/chain.txt ./output/wide.txt "$@"; do
+    name=`basename ${test_file} .txt`
+    all=$((all+1))
+    ./output/alloc_count < ${test_file} > ./output/counts
+    if [ $? -ne 0 ]; then
+        echo "${name}: too many allocations:"
+        echo "--------------------------------------------------------"
+        cat ./output/counts
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK"
+    fi
+done
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
@@ -0,0 +1,89 @@
+#!/bin/bash
+
+# Checks the run budgets on every grammar under tests/: a generous budget,
+# in limits that fit an int and in limits past 2^31 and 2^32, must not
+# change the output of Tasks 2-6, and a budget of one rule must stop Tasks 5
+# and 6 with exit status 3 whenever they create any rule. A limit that is
+# zero or not a number must be refused.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+let count=0
+let all=0
+
+mkdir -p ./output
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort); do
+    name=`basename ${test_file} .txt`
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR"; then
+        continue
+    fi
+    all=$((all+1))
+    rm -f ./output/diff
+
+    for task in 2 3 4 5 6; do
+        ./a.out ${task} < ${test_file} > ./output/expected
+        ./a.out ${task} --max-time=60000 --max-rules=1000000 \
+            --max-bytes=1000000000 < ${test_file} > ./output/limited
+        diff ./output/expected ./output/limited >> ./output/diff
+        ./a.out ${task} --max-rules=5000000000 --max-bytes=3000000000 \
+            < ${test_file} > ./output/limited
+        diff ./output/expected ./output/limited >> ./output/diff
+    done
+
+    # One rule is over budget as soon as a transform creates two
+    for task in 5 6; do
+        ./a.out ${task} --max-rules=1 < ${test_file} > ./output/limited
+        status=$?
+        if [ ${status} -eq 0 ]; then
+            continue
+        fi
+        if [ ${status} -ne 3 ] || ! grep -q "^Error: rule budget of 1 exceeded" ./output/limited; then
+            echo "Task ${task} --max-rules=1: exit status ${status}" >> ./output/diff
+            cat ./output/limited >> ./output/diff
+        fi
+    done
+
+    if [ -s ./output/diff ]; then
+        echo "${name}: budgeted run differs:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK"
+    fi
+done
+
+all=$((all+1))
+rm -f ./output/diff
+for limit in --max-bytes=0 --max-rules=-1 --max-bytes=12x \
+    --max-bytes=99999999999999999999 --chunk-bytes=; do
+    if ./a.out 4 ${limit} < tests/test02.txt > ./output/limited ||
+        ! grep -q "^Error: unrecognized option" ./output/limited; then
+        echo "${limit}: accepted" >> ./output/diff
+    fi
+done
+if [ -s ./output/diff ]; then
+    echo "invalid limits:"
+    echo "--------------------------------------------------------"
+    cat ./output/diff
+    echo "========================================================"
+else
+    count=$((count+1))
+    echo "invalid limits: OK"
+fi
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
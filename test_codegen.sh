@@ -0,0 +1,72 @@
+#!/bin/bash
+
+# Compiles the parser generated by Task 11 for every LL(1) grammar under
+# tests/ and checks that it, and the general (Earley) parse of Task 14,
+# accept and reject exactly the same sentences as the table-driven parse of
+# Task 12.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+
+let count=0
+let all=0
+let skipped=0
+
+mkdir -p ./output
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort); do
+    name=`basename ${test_file} .txt`
+    parser_file=./output/${name}.cpp
+    sentence_file=./output/${name}.sentences
+    ./a.out 11 < ${test_file} > ${parser_file}
+    echo
+    if grep -q "^Error" ${parser_file}; then
+        skipped=$((skipped+1))
+        echo "${name}: not LL(1), skipped"
+        echo "========================================================"
+        rm -f ${parser_file}
+        continue
+    fi
+    all=$((all+1))
+
+    # Shortest and random sentences, each followed by itself without its
+    # last token and with it doubled
+    (./a.out 13 --length=8 --count=500 < ${test_file}
+     ./a.out 15 --length=16 --count=500 < ${test_file} | grep -v "^Error") |
+        awk '{ print; if (NF > 0) { last = $NF; $NF = ""; print; print $0 " " last " " last } }' \
+        > ${sentence_file}
+
+    ${CXX} -std=c++11 -O2 -Wall -Wextra -Werror -DGENERATED_PARSER_MAIN \
+        ${parser_file} -o ./output/${name}.parser 2> ./output/${name}.diff
+    ./output/${name}.parser < ${sentence_file} > ./output/${name}.generated 2> /dev/null
+    ./a.out 12 --sentences=${sentence_file} < ${test_file} > ./output/${name}.table 2> /dev/null
+    ./a.out 14 --sentences=${sentence_file} < ${test_file} > ./output/${name}.earley 2> /dev/null
+    diff ./output/${name}.table ./output/${name}.generated >> ./output/${name}.diff
+    diff ./output/${name}.table ./output/${name}.earley >> ./output/${name}.diff
+
+    if [ -s ./output/${name}.diff ]; then
+        echo "${name}: generated or Earley parse does not match table-driven parse:"
+        echo "--------------------------------------------------------"
+        cat ./output/${name}.diff
+    else
+        count=$((count+1))
+        echo "${name}: OK ($(grep -c ACCEPT ./output/${name}.table) accepted, $(grep -c REJECT ./output/${name}.table) rejected)"
+    fi
+    echo "========================================================"
+    rm -f ./output/${name}.*
+done
+
+echo
+echo "Passed $count tests out of $all LL(1) grammars ($skipped skipped)"
+echo
+
+rmdir ./output
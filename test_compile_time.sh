@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# Checks the constexpr tables of include/compile_time.h against the runtime
+# engine: every grammar under tests/ is embedded in a generated header with
+# one static_assert per line of Nullable/FIRST/FOLLOW output from a.out and
+# one on the number of LL(1) conflicts, then tests/compile_time.cpp is
+# compiled as C++17. A mismatch is a compile error.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+
+mkdir -p ./output
+cases=./output/compile_time_cases.h
+: > ${cases}
+
+let all=0
+let skipped=0
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort); do
+    name=`basename ${test_file} .txt`
+    # compile_time.h reads plain BNF only
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR" ||
+        grep -q '[][(){}+]' ${test_file}; then
+        skipped=$((skipped+1))
+        continue
+    fi
+    all=$((all+1))
+
+    echo "static constexpr char ${name}[] = R\"grammar($(cat ${test_file}))grammar\";" >> ${cases}
+    echo "constexpr auto ${name}_tables = compile_time::analyze<${name}>();" >> ${cases}
+    for task in 2 3 4; do
+        ./a.out ${task} < ${test_file} | while read -r line || [ -n "${line}" ]; do
+            [ -z "${line}" ] && continue
+            echo "static_assert(compile_time::matches(${name}_tables, \"${line}\"), \"${name}: ${line}\");" >> ${cases}
+        done
+    done
+    conflicts=$(./a.out 11 < ${test_file} | grep -c "^CONFLICT")
+    echo "static_assert(${name}_tables.ll1_conflicts == ${conflicts}, \"${name}: ${conflicts} LL(1) conflicts\");" >> ${cases}
+done
+
+${CXX} -std=c++17 -Wall -Wextra -Wpedantic -Werror -I./include \
+    -DCOMPILE_TIME_CASES="\"../output/compile_time_cases.h\"" \
+    tests/compile_time.cpp -o ./output/compile_time 2> ./output/compile_time.diff
+
+echo
+if [ -s ./output/compile_time.diff ]; then
+    cat ./output/compile_time.diff
+    echo
+    echo "Failed: constexpr tables differ from a.out"
+    status=1
+else
+    echo "Passed $(grep -c static_assert ${cases}) checks on $all grammars ($skipped skipped)"
+    status=0
+fi
+echo
+
+rm -f ./output/compile_time*
+rmdir ./output
+exit ${status}
@@ -0,0 +1,95 @@
+#!/bin/bash
+
+# Checks Task 14 against a textbook Earley recognizer without Leo items or
+# nullable stepping (tests/earley_oracle.cpp), on every short sentence of
+# each grammar under tests/, of right-recursive and ambiguous grammars that
+# are not LL(1), and of randomly drawn small grammars. Sentences Task 15
+# generates for each grammar are checked as well, for longer inputs.
+#
+# Usage: ./test_earley.sh [grammar...]
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+
+mkdir -p ./output
+
+${CXX} -std=c++11 -O2 -I./include tests/earley_oracle.cpp \
+    $(ls src/*.cpp | grep -v project2.cpp) -pthread \
+    -o ./output/earley_oracle || exit 1
+
+# A Leo chain through set 0 must not jump over the completed start item
+cat > ./output/start_chain.txt << EOF2
+S -> A x | c B * A -> S * B -> a B | * #
+EOF2
+
+# Right recursion, with a common prefix and through the start symbol
+cat > ./output/right.txt << EOF2
+S -> a S | a | B * B -> b S | * #
+EOF2
+
+# Right-recursive expressions sharing prefixes
+cat > ./output/expr.txt << EOF2
+E -> T + E | T * T -> F x T | F * F -> ( E ) | i * #
+EOF2
+
+# Ambiguous, left and right recursive, nullable
+cat > ./output/ambiguous.txt << EOF2
+S -> S S | a S | S b | * #
+EOF2
+
+# Right recursion through a nullable tail and a second nonterminal
+cat > ./output/nullable_tail.txt << EOF2
+S -> A * A -> a A B | S b | * B -> * #
+EOF2
+
+let count=0
+let all=0
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort) \
+    ./output/start_chain.txt ./output/right.txt ./output/expr.txt \
+    ./output/ambiguous.txt ./output/nullable_tail.txt "$@"; do
+    name=`basename ${test_file} .txt`
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR"; then
+        continue
+    fi
+    all=$((all+1))
+    ./a.out 15 --count=200 --length=30 < ${test_file} 2> /dev/null |
+        grep -v "^Error" > ./output/sentences
+    ./output/earley_oracle ./output/sentences < ${test_file} > ./output/diff
+    if [ $? -ne 0 ]; then
+        echo "${name}: recognizers disagree:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK"
+    fi
+done
+
+all=$((all+1))
+./output/earley_oracle --random=500 > ./output/diff
+if [ $? -ne 0 ]; then
+    echo "random: recognizers disagree:"
+    echo "--------------------------------------------------------"
+    head -40 ./output/diff
+    echo "========================================================"
+else
+    count=$((count+1))
+    echo "random: OK"
+fi
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
@@ -0,0 +1,99 @@
+#!/bin/bash
+
+# Checks Task 5 with --factor=conflicts on every grammar under tests/, a
+# grammar with epsilon markers and any given on the command line: random
+# sentences of the grammar must be accepted by the factored grammar and the
+# other way round, it may not have more nonterminals than plain Task 5
+# (fewer, for the markers), and it must be LL(1) whenever that is.
+#
+# Usage: ./test_factor.sh [grammar...]
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+let count=0
+let all=0
+
+mkdir -p ./output
+touch ./output/no_sentences
+
+# Mid-rule markers derive only epsilon, so M a and M b are told apart by
+# a and b; N is nullable but also starts with n, so N c and N d clash
+cat > ./output/markers.txt << EOF
+S -> M a x | M a y | M b | N c | N d | M e S *
+M -> *
+N -> n | *
+#
+EOF
+
+# Rules printed by a.out, as grammar input, with the start symbol's first
+as_grammar() {
+    (grep "^$2 " $1; grep -v "^$2 " $1) | sed 's/#$/*/'
+    echo
+    echo "#"
+}
+
+non_terms() {
+    awk '{ print $1 }' $1 | sort -u | wc -l
+}
+
+is_ll1() {
+    ! ./a.out 12 --sentences=./output/no_sentences < $1 2> /dev/null |
+        grep -q "not LL(1)"
+}
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort) ./output/markers.txt "$@"; do
+    name=`basename ${test_file} .txt`
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR"; then
+        continue
+    fi
+    all=$((all+1))
+    rm -f ./output/diff
+    start=$(head -1 ${test_file} | awk '{ print $1 }')
+
+    ./a.out 5 < ${test_file} > ./output/all_rules
+    ./a.out 5 --factor=conflicts < ${test_file} > ./output/conflicts_rules
+    as_grammar ./output/all_rules ${start} > ./output/all
+    as_grammar ./output/conflicts_rules ${start} > ./output/conflicts
+
+    # Same language, both ways
+    for pair in "${test_file} ./output/conflicts" "./output/conflicts ${test_file}"; do
+        set -- ${pair}
+        ./a.out 15 --length=12 --count=300 < $1 | grep -v "^Error" > ./output/sentences
+        ./a.out 14 --sentences=./output/sentences < $2 2> /dev/null |
+            grep -n REJECT | head -3 >> ./output/diff
+    done
+
+    all_count=$(non_terms ./output/all_rules)
+    conflicts_count=$(non_terms ./output/conflicts_rules)
+    if [ ${conflicts_count} -gt ${all_count} ] ||
+        ([ ${test_file} = ./output/markers.txt ] && [ ${conflicts_count} -eq ${all_count} ]); then
+        echo "${conflicts_count} nonterminals, plain Task 5 has ${all_count}" >> ./output/diff
+    fi
+    if is_ll1 ./output/all && ! is_ll1 ./output/conflicts; then
+        echo "not LL(1), plain Task 5 is" >> ./output/diff
+    fi
+
+    if [ -s ./output/diff ]; then
+        echo "${name}: factored grammar differs:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK (${all_count} -> ${conflicts_count} nonterminals)"
+    fi
+done
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# Checks --format=ndjson and --format=binary against the text output of
+# Tasks 1-6, 10 and 16 on every grammar under tests/: tests/decode_format.cpp
+# turns each back into text, which must be byte-identical to what the task
+# prints without --format. Also checks that --format is refused, with a
+# non-zero exit, for a task that has no structured output.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+
+mkdir -p ./output
+
+${CXX} -std=c++11 -O2 tests/decode_format.cpp -o ./output/decode_format ||
+    exit 1
+
+let count=0
+let all=0
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort); do
+    name=`basename ${test_file} .txt`
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR"; then
+        continue
+    fi
+    all=$((all+1))
+    rm -f ./output/diff
+
+    for task in 1 2 3 4 5 6 10 16; do
+        ./a.out ${task} < ${test_file} > ./output/text 2> /dev/null
+        for format in ndjson binary; do
+            ./a.out ${task} --format=${format} < ${test_file} 2> /dev/null |
+                ./output/decode_format ${format} > ./output/decoded
+            if [ $? -ne 0 ] || ! cmp -s ./output/text ./output/decoded; then
+                echo "Task ${task}, ${format}:" >> ./output/diff
+                diff ./output/text ./output/decoded | head -6 >> ./output/diff
+            fi
+        done
+    done
+
+    if [ -s ./output/diff ]; then
+        echo "${name}: decoded output differs:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK"
+    fi
+done
+
+all=$((all+1))
+if ./a.out 7 --format=ndjson < tests/test01.txt > ./output/text; then
+    echo "task 7: --format=ndjson accepted:"
+    echo "--------------------------------------------------------"
+    head -3 ./output/text
+    echo "========================================================"
+else
+    count=$((count+1))
+    echo "task 7: OK (--format refused)"
+fi
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
@@ -0,0 +1,115 @@
+#!/bin/bash
+
+# Checks Task 15 on every grammar under tests/ and a grammar whose shortest
+# sentence needs the tallest tree: every sentence must be accepted by Task 14
+# and have at most --length terminals, and a --length/--depth pair that no
+# sentence meets must be rejected with an error instead of a sentence.
+#
+# Usage: ./test_generator.sh
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+let count=0
+let all=0
+
+mkdir -p ./output
+
+# "a a a" is 2 high, "b" is 5 high: --length=1 --depth=2 fits neither
+cat > ./output/tall.txt << EOF
+S -> A *
+A -> a a a | B *
+B -> C *
+C -> D *
+D -> b *
+#
+EOF
+
+# Sentences for $1 with options $2 must be accepted and at most $3 long
+check_sentences() {
+    ./a.out 15 --count=200 $2 < $1 > ./output/sentences
+    if grep -q "^Error" ./output/sentences; then
+        echo "$2: $(head -1 ./output/sentences)" >> ./output/diff
+        return
+    fi
+    awk -v max=$3 'NF > max { print "'"$2"': " NR ": " NF " terminals" }' \
+        ./output/sentences | head -3 >> ./output/diff
+    ./a.out 14 --sentences=./output/sentences < $1 2> /dev/null |
+        grep REJECT | sed "s/^/$2: /" | head -3 >> ./output/diff
+}
+
+# Sentences for $1 with options $2 must all be exactly $3
+check_only() {
+    ./a.out 15 --count=50 $2 < $1 | sort -u > ./output/sentences
+    if [ "$(cat ./output/sentences)" != "$3" ]; then
+        echo "$2: expected \"$3\", got:" >> ./output/diff
+        head -3 ./output/sentences >> ./output/diff
+    fi
+}
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort); do
+    name=`basename ${test_file} .txt`
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR"; then
+        continue
+    fi
+    if ./a.out 15 --count=1 < ${test_file} | grep -q "^Error"; then
+        continue
+    fi
+    all=$((all+1))
+    rm -f ./output/diff
+
+    # Limits below a grammar's shortest sentence are raised to it, so only
+    # check the length where it is the one asked for
+    shortest=$(./a.out 15 --count=1 --length=1 < ${test_file} | wc -w)
+    for length in 4 10 30; do
+        if [ ${length} -ge ${shortest} ]; then
+            check_sentences ${test_file} "--length=${length} --depth=8" ${length}
+        else
+            check_sentences ${test_file} "--length=${length} --depth=8" 1000000
+        fi
+    done
+
+    if [ -s ./output/diff ]; then
+        echo "${name}: sentences differ:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK"
+    fi
+done
+
+all=$((all+1))
+rm -f ./output/diff
+./a.out 15 --length=1 --depth=2 --count=3 < ./output/tall.txt > ./output/sentences
+if ! grep -q "^Error" ./output/sentences || [ $(grep -c "" ./output/sentences) -ne 1 ]; then
+    echo "--length=1 --depth=2: expected an error, got:" >> ./output/diff
+    head -3 ./output/sentences >> ./output/diff
+fi
+check_only ./output/tall.txt "--length=3 --depth=2" "a a a"
+check_only ./output/tall.txt "--length=1 --depth=5" "b"
+check_only ./output/tall.txt "--length=2 --depth=5" "b"
+check_sentences ./output/tall.txt "--length=3 --depth=5" 3
+if [ -s ./output/diff ]; then
+    echo "tall: sentences differ:"
+    echo "--------------------------------------------------------"
+    cat ./output/diff
+    echo "========================================================"
+else
+    count=$((count+1))
+    echo "tall: OK"
+fi
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
@@ -0,0 +1,55 @@
+#!/bin/bash
+
+# Checks the parallel ingest on every grammar under tests/: parsed in
+# 16-byte chunks, Tasks 1-6 must print exactly what the sequential parser
+# prints, syntax errors (and their line on stderr) included.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+let count=0
+let all=0
+
+mkdir -p ./output
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort); do
+    name=`basename ${test_file} .txt`
+    all=$((all+1))
+    rm -f ./output/diff
+
+    for task in 1 2 3 4 5 6; do
+        ./a.out ${task} < ${test_file} > ./output/expected 2>&1
+        ./a.out ${task} --ingest=parallel --chunk-bytes=16 \
+            < ${test_file} > ./output/chunked 2>&1
+        diff ./output/expected ./output/chunked >> ./output/diff
+    done
+
+    # Through a pipe, the input is read into memory before it is split
+    cat ${test_file} | ./a.out 2 --ingest=parallel --chunk-bytes=16 \
+        > ./output/chunked 2>&1
+    ./a.out 2 < ${test_file} > ./output/expected 2>&1
+    diff ./output/expected ./output/chunked >> ./output/diff
+
+    if [ -s ./output/diff ]; then
+        echo "${name}: chunked parse differs:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK"
+    fi
+done
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
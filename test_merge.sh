@@ -0,0 +1,76 @@
+#!/bin/bash
+
+# Checks Task 16 on every grammar under tests/: random sentences of the
+# grammar must be accepted by the merged grammar and the other way round,
+# and Tasks 5 and 6 with --merge must print what Task 16 prints for their
+# output.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+let count=0
+let all=0
+
+mkdir -p ./output
+
+# Rules printed by a.out, as grammar input
+as_grammar() {
+    sed 's/#$/*/' $1
+    echo
+    echo "#"
+}
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort); do
+    name=`basename ${test_file} .txt`
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR"; then
+        continue
+    fi
+    all=$((all+1))
+    rm -f ./output/diff
+    ./a.out 16 < ${test_file} > ./output/rules 2> ./output/stats
+
+    # Printed rules are sorted; the start symbol's go first to keep it
+    start=$(head -1 ${test_file} | awk '{ print $1 }')
+    (grep "^${start} " ./output/rules; grep -v "^${start} " ./output/rules) \
+        > ./output/start_first
+    as_grammar ./output/start_first > ./output/merged
+
+    # Same language, both ways
+    for pair in "${test_file} ./output/merged" "./output/merged ${test_file}"; do
+        set -- ${pair}
+        ./a.out 15 --length=12 --count=300 < $1 | grep -v "^Error" > ./output/sentences
+        ./a.out 14 --sentences=./output/sentences < $2 2> /dev/null |
+            grep -n REJECT | head -3 >> ./output/diff
+    done
+
+    for task in 5 6; do
+        ./a.out ${task} < ${test_file} > ./output/transformed
+        as_grammar ./output/transformed > ./output/grammar
+        ./a.out 16 < ./output/grammar > ./output/expected 2> /dev/null
+        ./a.out ${task} --merge < ${test_file} 2> /dev/null > ./output/piped
+        diff ./output/expected ./output/piped >> ./output/diff
+    done
+
+    if [ -s ./output/diff ]; then
+        echo "${name}: merged grammar differs:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK ($(cat ./output/stats))"
+    fi
+done
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
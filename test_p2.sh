@@ -22,7 +22,7 @@ usage()
     echo
     echo "Usage: $0 n"
     echo
-    echo "Where n is the desired task number in range [1..5]"
+    echo "Where n is the desired task number in range [1..10]"
     echo
     exit 1
 }
@@ -37,8 +37,8 @@ if [[ ! "$1" =~ ^[0-9]+$ ]]; then
     usage
 fi
 
-if [ "$1" -lt "1" -o "$1" -gt "6" ]; then
-    echo "Error: argument must be a number in range [1..5]"
+if [ "$1" -lt "1" -o "$1" -gt "10" ]; then
+    echo "Error: argument must be a number in range [1..10]"
     usage
 fi
 
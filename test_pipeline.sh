@@ -0,0 +1,122 @@
+#!/bin/bash
+
+# Checks that every --pipeline run prints what chaining the tasks through
+# their text output prints: each transform's rules are turned back into
+# grammar input ("A -> x y #" becomes "A -> x y *"), listed by lhs in the
+# nonterminal order of the grammar the transform read (new nonterminals
+# last), and fed to the next task. A grammar whose start symbol is not
+# alphabetically first must keep it.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+PIPELINES="unleftrec,factor,first,follow reduce,unleftrec,factor,follow
+factor,unleftrec,nullable reduce,factor,symbols unleftrec,unleftrec
+unleftrec,merge,first factor,merge unleftrec,reduce unleftrec,follow"
+
+declare -A TASK_OF=([reduce]=10 [unleftrec]=6 [factor]=5 [merge]=16
+                    [symbols]=1 [nullable]=2 [first]=3 [follow]=4)
+
+let count=0
+let all=0
+
+mkdir -p ./output
+
+# Transform output $2 of grammar $1, one rule per line, ordered by the rank
+# of its lhs in $1's symbols (Task 1); rules of one lhs keep their order
+list_by_lhs() {
+    awk 'NR == FNR { for (i = 1; i <= NF; i++) rank[$i] = i; next }
+         { print ($1 in rank ? rank[$1] : 1000000) "\t" FNR "\t" $0 }' \
+        <(./a.out 1 < $1 2> /dev/null) $2 | sort -n -k1,1 -k2,2 | cut -f3-
+}
+
+# S sorts after A, and A is left unreachable once it is substituted into S
+cat > ./output/start.txt << EOF
+S -> A b | S c * A -> a * #
+EOF
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort) ./output/start.txt; do
+    name=`basename ${test_file} .txt`
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR"; then
+        continue
+    fi
+    for pipeline in ${PIPELINES}; do
+        all=$((all+1))
+        cp ${test_file} ./output/grammar
+
+        # Analyses print, transforms only when last; headers separate
+        # sections when there is more than one
+        stages=(${pipeline//,/ })
+        sections=()
+        for i in ${!stages[@]}; do
+            stage=${stages[$i]}
+            task=${TASK_OF[$stage]}
+            ./a.out ${task} < ./output/grammar > ./output/stage.${i} 2> /dev/null
+            if [ ${task} -ge 5 ]; then
+                (list_by_lhs ./output/grammar ./output/stage.${i} |
+                    sed 's/#$/*/'; echo; echo "#") > ./output/next
+                mv ./output/next ./output/grammar
+            fi
+            if [ ${task} -lt 5 ] || [ $((i+1)) -eq ${#stages[@]} ]; then
+                sections+=(${i})
+            fi
+        done
+        rm -f ./output/chained
+        for j in ${!sections[@]}; do
+            i=${sections[$j]}
+            [ ${j} -gt 0 ] && echo >> ./output/chained
+            [ ${#sections[@]} -gt 1 ] && echo "== ${stages[$i]} ==" >> ./output/chained
+            cat ./output/stage.${i} >> ./output/chained
+        done
+
+        ./a.out --pipeline=${pipeline} < ${test_file} > ./output/piped
+        status=$?
+        # A transform that leaves no rules prints nothing to re-parse
+        if grep -q "SYNTAX ERROR" ./output/chained; then
+            grep -q "^Error: no rules left" ./output/piped && [ ${status} -ne 0 ]
+            matched=$?
+        else
+            diff ./output/chained ./output/piped > ./output/diff
+            matched=$?
+            if [ ${status} -ne 0 ]; then
+                echo "exit status ${status}" >> ./output/diff
+                matched=1
+            fi
+        fi
+        if [ ${matched} -eq 0 ]; then
+            count=$((count+1))
+        else
+            echo "${name} --pipeline=${pipeline}: does not match chained tasks:"
+            echo "--------------------------------------------------------"
+            cat ./output/diff
+            echo "========================================================"
+        fi
+    done
+done
+
+# Without the chained runs to compare against: the start symbol survives
+all=$((all+1))
+(./a.out --pipeline=unleftrec,reduce; echo) < ./output/start.txt > ./output/piped
+./a.out --pipeline=unleftrec,follow < ./output/start.txt >> ./output/piped
+if grep -q "^S -> a b S1 #" ./output/piped &&
+    grep -q "^FOLLOW(S) = { \$ }" ./output/piped; then
+    count=$((count+1))
+else
+    echo "start: start symbol lost:"
+    echo "--------------------------------------------------------"
+    cat ./output/piped
+    echo "========================================================"
+fi
+
+echo
+echo "Passed $count tests out of $all pipelines"
+echo
+
+rm -rf ./output
@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# Checks the DFAs of Task 17 against the Earley recognizer of Task 14. For
+# every grammar under tests/, each nonterminal compiled into a DFA and with
+# rules of its own in the file is made the start symbol (its rules moved
+# first); generated sentences of it and mutations of them (last token
+# dropped, first token doubled, reversed) must get the same ACCEPT/REJECT
+# from both.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+let count=0
+let all=0
+
+mkdir -p ./output
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort); do
+    name=`basename ${test_file} .txt`
+    if ./a.out 1 < ${test_file} | grep -q "SYNTAX ERROR"; then
+        continue
+    fi
+    all=$((all+1))
+    rm -f ./output/diff
+
+    for non_term in $(./a.out 17 < ${test_file} 2> /dev/null | sed -n 's/^DFA(\(.*\)) = .*/\1/p'); do
+        # Symbols made up by EBNF rewriting have no rules of their own here
+        if ! grep -q "^${non_term} ->" ${test_file}; then
+            continue
+        fi
+        grep "^${non_term} ->" ${test_file} > ./output/grammar.txt
+        grep -v "^${non_term} ->" ${test_file} >> ./output/grammar.txt
+
+        {
+            ./a.out 13 --length=8 --count=50 < ./output/grammar.txt
+            ./a.out 15 --length=12 --count=100 < ./output/grammar.txt
+        } | grep -v "^Error" > ./output/generated
+        awk '{ print } NF > 0 { $NF = ""; print; print $1 " " $0 }
+             { line = ""; for (i = NF; i > 0; i--) line = line " " $i; print line }' \
+            ./output/generated > ./output/sentences
+
+        ./a.out 14 --sentences=./output/sentences < ./output/grammar.txt \
+            > ./output/earley 2> /dev/null
+        ./a.out 17 --sentences=./output/sentences < ./output/grammar.txt \
+            > ./output/dfa 2> /dev/null
+        if ! diff -q ./output/earley ./output/dfa > /dev/null; then
+            echo "${non_term}:" >> ./output/diff
+            paste ./output/earley ./output/dfa ./output/sentences |
+                awk -F'\t' '$1 != $2' >> ./output/diff
+        fi
+    done
+
+    if [ -s ./output/diff ]; then
+        echo "${name}: DFA and Earley disagree:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK"
+    fi
+done
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
@@ -0,0 +1,193 @@
+#!/bin/bash
+
+# Checks --serve over standard input and over a socket, driven by
+# tests/server_client.cpp: TASK answers match what a.out prints for the
+# same grammar, ADD and REMOVE edit the cached grammar, a syntax error, an
+# unknown command and a run over budget get ERR, STATS counts requests and
+# cache hits, SHUTDOWN stops the server. Over the socket, a grammar file
+# changed on disk is read again, --cache=1 evicts the other file's entry,
+# and a short --loadgen run completes without errors.
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+if [ ! -x "./a.out" ]; then
+    echo "Error: a.out not found or not executable!"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+
+rm -rf ./output
+mkdir -p ./output
+
+${CXX} -std=c++11 -O2 tests/server_client.cpp -o ./output/server_client ||
+    exit 1
+
+let count=0
+let all=0
+
+# Records a failed check of the current test
+fail() {
+    echo "$1" >> ./output/diff
+}
+
+# Response $2 in directory $1 must have status $3
+expect_status() {
+    if [ "$(cat $1/$2.status 2> /dev/null)" != "$3" ]; then
+        fail "response $2: expected $3, got: $(cat $1/$2.status $1/$2 2> /dev/null)"
+        return 1
+    fi
+}
+
+# Response $2 in directory $1 must be OK with the output of a.out $3 < $4
+expect_task() {
+    expect_status $1 $2 OK || return
+    ./a.out $3 < $4 > ./output/expected 2> /dev/null
+    if ! cmp -s ./output/expected $1/$2; then
+        fail "response $2: differs from a.out $3 < $(basename $4):"
+        diff ./output/expected $1/$2 | head -6 >> ./output/diff
+    fi
+}
+
+# Response $2 in directory $1 must contain the line $3
+expect_line() {
+    if ! grep -qxF "$3" $1/$2 2> /dev/null; then
+        fail "response $2: no line \"$3\" in: $(cat $1/$2 2> /dev/null)"
+    fi
+}
+
+# Prints the result of the test named $1 from ./output/diff
+report() {
+    all=$((all+1))
+    if [ -s ./output/diff ]; then
+        echo "$1: failed:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "$1: OK"
+    fi
+    rm -f ./output/diff
+}
+
+cp tests/test02.txt ./output/grammar.txt
+cp tests/test03.txt ./output/other.txt
+echo "S -> a -> b * #" > ./output/bad.txt
+# The grammar with X -> x appended, as ADD makes it
+(sed 's/#[[:space:]]*$//' tests/test02.txt; echo "X -> x *"; echo "#") \
+    > ./output/added.txt
+
+G=./output/grammar.txt
+
+# Over standard input, with a budget of one rule
+mkdir -p ./output/stdio
+cat > ./output/requests << EOF
+TASK 1 ${G}
+TASK 3 ${G}
+TASK 1 ./output/bad.txt
+TASK 6 ${G}
+ADD ${G} X -> x *
+TASK 1 ${G}
+REMOVE ${G} X -> x *
+TASK 1 ${G}
+TASK 1 ./output/missing.txt
+FROB
+STATS
+SHUTDOWN
+TASK 1 ${G}
+EOF
+./a.out --serve=stdio --max-rules=1 < ./output/requests |
+    ./output/server_client --stdio ./output/stdio
+statuses=(${PIPESTATUS[@]})
+if [ ${statuses[0]} -ne 0 ] || [ ${statuses[1]} -ne 0 ]; then
+    fail "server or client exited with an error"
+fi
+expect_task ./output/stdio 1 1 ${G}
+expect_task ./output/stdio 2 3 ${G}
+expect_status ./output/stdio 3 ERR
+expect_status ./output/stdio 4 ERR && grep -q "budget" ./output/stdio/4 ||
+    fail "response 4: not a budget error"
+expect_status ./output/stdio 5 OK
+expect_task ./output/stdio 6 1 ./output/added.txt
+expect_status ./output/stdio 7 OK
+expect_task ./output/stdio 8 1 ${G}
+expect_status ./output/stdio 9 ERR
+expect_status ./output/stdio 10 ERR
+expect_status ./output/stdio 11 OK &&
+    expect_line ./output/stdio 11 "requests = 10"
+expect_status ./output/stdio 12 OK
+if [ -e ./output/stdio/13 ]; then
+    fail "response 13: answered a request after SHUTDOWN"
+fi
+report "stdio"
+
+# Over a socket, with room for one grammar in the cache
+SOCKET=./output/server.sock
+./a.out --serve=${SOCKET} --cache=1 2> ./output/server.err &
+server=$!
+for i in $(seq 1 100); do
+    [ -S ${SOCKET} ] && break
+    sleep 0.1
+done
+
+# Requests $2 on a new connection, responses in directory $1
+session() {
+    rm -rf $1
+    mkdir -p $1
+    printf "$2" | ./output/server_client ${SOCKET} $1 ||
+        fail "$1: client exited with an error"
+}
+
+session ./output/socket "TASK 1 ${G}\nTASK 1 ${G}\nTASK 3 ${G}\nSTATS\n"
+expect_task ./output/socket 1 1 ${G}
+expect_task ./output/socket 2 1 ${G}
+expect_task ./output/socket 3 3 ${G}
+expect_line ./output/socket 4 "cache hits = 2"
+expect_line ./output/socket 4 "cache misses = 1"
+report "socket"
+
+# A new file size and mtime make the path+hash key change
+cp ./output/added.txt ${G}
+session ./output/changed "TASK 1 ${G}\nSTATS\n"
+expect_task ./output/changed 1 1 ./output/added.txt
+expect_line ./output/changed 2 "cache misses = 2"
+report "changed file"
+
+# --cache=1: the other grammar evicts this one, which is then parsed again
+session ./output/evict "TASK 1 ./output/other.txt\nTASK 1 ${G}\nSTATS\n"
+expect_task ./output/evict 1 1 ./output/other.txt
+expect_task ./output/evict 2 1 ./output/added.txt
+expect_line ./output/evict 3 "cache hits = 2"
+expect_line ./output/evict 3 "cache misses = 4"
+report "eviction"
+
+./a.out --loadgen=${SOCKET} --grammar=${G} --task=3 --clients=4 \
+    --requests=50 > ./output/load
+if [ $? -ne 0 ]; then
+    fail "--loadgen exited with an error"
+fi
+grep -qx "requests = 200" ./output/load || fail "$(cat ./output/load)"
+grep -qx "errors = 0" ./output/load || fail "$(cat ./output/load)"
+report "loadgen"
+
+session ./output/shutdown "SHUTDOWN\n"
+expect_status ./output/shutdown 1 OK
+wait ${server}
+status=$?
+if [ ${status} -ne 0 ]; then
+    fail "server exited with status ${status}: $(cat ./output/server.err)"
+fi
+if [ -e ${SOCKET} ]; then
+    fail "socket left behind"
+fi
+report "shutdown"
+
+echo
+echo "Passed $count tests out of $all server checks"
+echo
+
+rm -rf ./output
@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# Checks the suffix FIRST table behind FOLLOW and the LL(1) table directly:
+# tests/suffix_first.cpp compares FIRST and nullability of every rhs suffix,
+# and of every single symbol, with what the sets of Tasks 2 and 3 give, on
+# every grammar under tests/, one with nullable chains and shared suffixes,
+# and any given on the command line.
+#
+# Usage: ./test_suffix_first.sh [grammar...]
+
+if [ ! -d "./tests" ]; then
+    echo "Error: tests directory not found!"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+
+mkdir -p ./output
+
+${CXX} -std=c++11 -O2 -I./include tests/suffix_first.cpp \
+    $(ls src/*.cpp | grep -v project2.cpp) -pthread \
+    -o ./output/suffix_first || exit 1
+
+# Suffixes shared between rules, behind nullable symbols of their own
+cat > ./output/shared.txt << EOF
+S -> A B c | B B c | d A B c *
+A -> a | B * B -> b | * C -> A B * D -> C C A | e #
+EOF
+
+let count=0
+let all=0
+
+for test_file in $(find "./tests" -type f -name "*.txt" | sort) ./output/shared.txt "$@"; do
+    name=`basename ${test_file} .txt`
+    all=$((all+1))
+    ./output/suffix_first < ${test_file} > ./output/diff
+    if [ $? -ne 0 ]; then
+        echo "${name}: suffix FIRST differs:"
+        echo "--------------------------------------------------------"
+        cat ./output/diff
+        echo "========================================================"
+    else
+        count=$((count+1))
+        echo "${name}: OK"
+    fi
+done
+
+echo
+echo "Passed $count tests out of $all grammars"
+echo
+
+rm -rf ./output
@@ -0,0 +1,255 @@
+// Allocation counts for everything Tasks 2-6 do, from lexing and parsing
+// through the analyses, the rule map round trip and the transforms. Global
+// operator new is replaced by a counting one; the grammar on standard input
+// is loaded, then each phase runs on its own copy and prints to a stream
+// that discards its output.
+//
+// Every phase runs twice: once with the grammar's own names, short enough
+// for the small-string buffer, and once with each name behind a long common
+// prefix, which keeps their order. The difference is the number of names
+// the phase copied, which is bounded by the size of the grammar and of the
+// result with no slack for a second copy per symbol occurrence. All
+// allocations of the long run are bounded as well, with no room for any
+// per fixpoint pass.
+//
+// Prints one line per phase and exits 1 if any is over a bound.
+#include "analysis.h"
+#include "parser.h"
+#include "types.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+size_t allocations = 0;
+
+const std::string LONG_PREFIX = "Paddedpastthesmallstringbuffer";
+
+// Swallows output without allocating
+class NullBuffer : public std::streambuf {
+  protected:
+    auto overflow(int c) -> int override { return c; }
+    auto xsputn(const char *, std::streamsize n) -> std::streamsize override {
+        return n;
+    }
+};
+
+template <typename Fn> auto count(Fn fn) -> size_t {
+    size_t before = allocations;
+    fn();
+    return allocations - before;
+}
+
+auto set_sizes(const SetMap &map) -> size_t {
+    size_t size = 0;
+    for (const auto &pair : map) {
+        size += pair.second.size();
+    }
+    return size;
+}
+
+// Names on either side of the rules: one per lhs and one per rhs symbol
+auto occurrences(const std::vector<Rule> &rules) -> size_t {
+    size_t size = 0;
+    for (const Rule &rule : rules) {
+        size += 1 + rule.rhs.size();
+    }
+    return size;
+}
+
+// Puts LONG_PREFIX in front of every name the lexer would read as an ID
+auto lengthen_names(const std::string &text) -> std::string {
+    std::string res;
+    bool in_name = false;
+    for (char c : text) {
+        bool starts = !in_name && std::isalpha(static_cast<unsigned char>(c));
+        in_name = (in_name || starts) &&
+                  std::isalnum(static_cast<unsigned char>(c)) != 0;
+        if (starts) {
+            res += LONG_PREFIX;
+        }
+        res += c;
+    }
+    return res;
+}
+
+struct Phase {
+    const char *name;
+    size_t allocations;
+    // Elements of an analysis's results, or names in a transform's rules
+    size_t result;
+};
+
+// Runs every phase on the grammar in text. Returns false on a syntax error.
+auto run_phases(const std::string &text, Grammar &grammar,
+                std::vector<Phase> &phases) -> bool {
+    NullBuffer buffer;
+    std::ostream discard(&buffer);
+    std::istringstream in(text);
+
+    bool parsed = true;
+    phases.push_back({"parse", count([&]() {
+                          try {
+                              Parser parser(in);
+                              parser.parse_input();
+                              grammar = parser.generate_grammar();
+                          } catch (const SyntaxError &) {
+                              parsed = false;
+                          }
+                      }),
+                      0});
+    if (!parsed) {
+        return false;
+    }
+
+    // FIRST needs nullable and FOLLOW needs both, so their results count
+    size_t result = 0;
+    phases.push_back({"nullable", count([&]() {
+                          result += analysis::calc_nullable(grammar).size();
+                          analysis::print_nullable_set(grammar, discard);
+                      }),
+                      0});
+    phases.back().result = result;
+    phases.push_back({"FIRST", count([&]() {
+                          result += set_sizes(analysis::calc_first(grammar));
+                          analysis::print_first_sets(grammar, discard);
+                      }),
+                      0});
+    phases.back().result = result;
+    phases.push_back({"FOLLOW", count([&]() {
+                          result += set_sizes(analysis::calc_follow(grammar));
+                          analysis::print_follow_sets(grammar, discard);
+                      }),
+                      0});
+    phases.back().result = result;
+
+    std::vector<Rule> rules = grammar.rules;
+    RuleMap rule_map;
+    phases.push_back({"gen_rule_map", count([&]() {
+                          rule_map = analysis::gen_rule_map(std::move(rules));
+                      }),
+                      0});
+    phases.push_back({"rule_map_to_vec", count([&]() {
+                          rules =
+                              analysis::rule_map_to_vec(std::move(rule_map));
+                      }),
+                      0});
+
+    Grammar copy = grammar;
+    phases.push_back({"Task 5", count([&]() {
+                          rules = analysis::calc_left_factored(std::move(copy));
+                          analysis::print_rules(rules, discard);
+                      }),
+                      0});
+    phases.back().result = occurrences(rules);
+
+    copy = grammar;
+    phases.push_back({"Task 6", count([&]() {
+                          rules = analysis::eliminate_left_recursion(
+                              std::move(copy));
+                          analysis::print_rules(rules, discard);
+                      }),
+                      0});
+    phases.back().result = occurrences(rules);
+    return true;
+}
+
+// Every symbol and rule may cost a fixed number of allocations (map nodes,
+// interned names, bucket arrays, ordered vectors to print), and so may every
+// name in the rules (tokens, the FOLLOW suffix table) and every element of
+// the results. Nothing may cost allocations per pass.
+auto bound(const Phase &phase, const Grammar &grammar) -> size_t {
+    size_t symbols = grammar.terms.size() + grammar.non_terms.size();
+    return 16 * (symbols + grammar.rules.size()) +
+           4 * (occurrences(grammar.rules) + phase.result) + 64;
+}
+
+// Names copied. The parser keeps the lexer's copy of every name it reads
+// and copies it once into its rule, and each symbol has an entry in a set
+// and a list for the universe and again for the terminals or nonterminals
+// (EBNF helpers take a couple more to be named). The rule map has a key per
+// nonterminal. The analyses intern the symbols and store a name per element
+// of their results, twice as printing runs them again. A transform copies
+// each name at most once, into a rule it makes, so no more than the larger
+// of its input and output hold.
+auto name_bound(const Phase &phase, const Grammar &grammar) -> size_t {
+    size_t symbols = grammar.terms.size() + grammar.non_terms.size();
+    size_t names = occurrences(grammar.rules);
+    std::string name = phase.name;
+    if (name == "parse") {
+        return 2 * names + 6 * symbols + 8;
+    }
+    if (name == "gen_rule_map") {
+        return grammar.non_terms.size();
+    }
+    if (name == "rule_map_to_vec") {
+        return 0;
+    }
+    if (name == "Task 5" || name == "Task 6") {
+        return std::max(names, phase.result) + 4 * symbols + 8;
+    }
+    return 2 * phase.result + 10 * symbols + 8;
+}
+
+auto report(const Phase &phase, size_t names, const Grammar &grammar) -> bool {
+    size_t limit = bound(phase, grammar);
+    size_t name_limit = name_bound(phase, grammar);
+    bool ok = phase.allocations <= limit && names <= name_limit;
+    std::cout << phase.name << ": " << phase.allocations
+              << " allocations (bound " << limit << "), " << names
+              << " names (bound " << name_limit << ")" << (ok ? "" : " OVER")
+              << "\n";
+    return ok;
+}
+
+} // namespace
+
+auto operator new(size_t size) -> void * {
+    allocations++;
+    void *data = std::malloc(size == 0 ? 1 : size);
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+auto operator delete(void *data) noexcept -> void { std::free(data); }
+
+auto operator delete(void *data, size_t) noexcept -> void { std::free(data); }
+
+auto main() -> int {
+    std::string text((std::istreambuf_iterator<char>(std::cin)),
+                     std::istreambuf_iterator<char>());
+    std::string long_text = lengthen_names(text);
+
+    Grammar grammar;
+    Grammar long_grammar;
+    std::vector<Phase> phases;
+    std::vector<Phase> long_phases;
+    if (!run_phases(text, grammar, phases) ||
+        !run_phases(long_text, long_grammar, long_phases)) {
+        std::cout << "SYNTAX ERROR !!!!!!!!!!!!!!\n";
+        return 0;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < long_phases.size(); i++) {
+        const Phase &phase = long_phases[i];
+        size_t names = phase.allocations > phases[i].allocations
+                           ? phase.allocations - phases[i].allocations
+                           : 0;
+        ok &= report(phase, names, long_grammar);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+// Compile-time checks for include/compile_time.h. Passing means compiling:
+// every assertion is a static_assert. test_compile_time.sh generates
+// COMPILE_TIME_CASES from a.out's output for each grammar under tests/.
+#include "compile_time.h"
+
+namespace {
+
+static constexpr char expression[] = R"grammar(
+E -> T Ep *
+Ep -> PLUS T Ep | *
+T -> F Tp *
+Tp -> MULT F Tp | *
+F -> LPAREN E RPAREN | NUM *
+#)grammar";
+
+constexpr auto expression_tables = compile_time::analyze<expression>();
+constexpr const auto &expression_grammar = expression_tables.grammar;
+
+// Interning follows first appearance, terminals first
+static_assert(expression_grammar.num_terms == 5, "terminal count");
+static_assert(expression_grammar.num_symbols == 10, "symbol count");
+static_assert(expression_grammar.names[0] == "PLUS", "first terminal");
+static_assert(expression_grammar.names[expression_grammar.start()] == "E",
+              "start symbol");
+
+static_assert(compile_time::matches(expression_tables, "Nullable = { Ep, Tp }"),
+              "nullable");
+static_assert(compile_time::matches(expression_tables,
+                                    "FIRST(T) = { LPAREN, NUM }"),
+              "FIRST(T)");
+static_assert(!compile_time::matches(expression_tables,
+                                     "FIRST(T) = { NUM }"),
+              "FIRST(T) is not missing LPAREN");
+static_assert(compile_time::matches(expression_tables,
+                                    "FOLLOW(Tp) = { $, PLUS, RPAREN }"),
+              "FOLLOW(Tp)");
+
+// F -> NUM on NUM, Ep -> epsilon on $
+static_assert(expression_tables.is_ll1(), "expression grammar is LL(1)");
+static_assert(expression_tables.entry(expression_grammar.id("F"),
+                                      expression_grammar.id("NUM")) == 7,
+              "F on NUM");
+static_assert(expression_tables.entry(expression_grammar.id("Ep"),
+                                      expression_tables.end_marker()) == 2,
+              "Ep on $");
+static_assert(expression_tables.entry(expression_grammar.id("E"),
+                                      expression_grammar.id("PLUS")) == -1,
+              "E on PLUS is an error");
+
+static constexpr char ambiguous[] = "S -> a S | a | * #";
+static_assert(compile_time::analyze<ambiguous>().ll1_conflicts == 1,
+              "S on a is claimed twice");
+
+#ifdef COMPILE_TIME_CASES
+#include COMPILE_TIME_CASES
+#endif
+
+} // namespace
+
+auto main() -> int { return 0; }
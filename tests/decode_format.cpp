@@ -0,0 +1,240 @@
+// Turns the ndjson or binary output of Tasks 1-6, 10 and 16 (include/output.h)
+// back into the text those tasks print, so test_format.sh can diff the two.
+// Reads standard input, writes standard output.
+//
+// Usage: decode_format ndjson|binary
+//
+// Exits 1 on a record it can't read, including a binary record whose
+// length doesn't match its fields.
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint8_t RECORD_SYMBOL = 1;
+const uint8_t RECORD_SET = 2;
+const uint8_t RECORD_RULE = 3;
+
+// Text of the records so far: Task 1 prints all its symbols on one line,
+// everything else one line per record
+class TextWriter {
+  public:
+    auto symbol(const std::string &name) -> void {
+        if (in_symbols) {
+            text += " ";
+        } else {
+            start_line();
+            in_symbols = true;
+        }
+        text += name;
+    }
+
+    auto set(const std::string &set_name, const std::string &symbol,
+             const std::vector<std::string> &members) -> void {
+        start_line();
+        text += set_name;
+        if (!symbol.empty()) {
+            text += "(" + symbol + ")";
+        }
+        text += " = { ";
+        for (size_t i = 0; i < members.size(); i++) {
+            text += (i > 0 ? ", " : "") + members[i];
+        }
+        text += " }";
+    }
+
+    auto rule(const std::string &lhs, const std::vector<std::string> &rhs)
+        -> void {
+        start_line();
+        text += lhs + " -> ";
+        for (size_t i = 0; i < rhs.size(); i++) {
+            text += (i > 0 ? " " : "") + rhs[i];
+        }
+        text += " #";
+    }
+
+    std::string text;
+
+  private:
+    bool lines = false;
+    bool in_symbols = false;
+
+    auto start_line() -> void {
+        if (lines) {
+            text += "\n";
+        }
+        lines = true;
+        in_symbols = false;
+    }
+};
+
+// The quoted strings of an ndjson line, keys and values alike. Names are
+// never escaped, so a string ends at the next quote.
+auto json_strings(const std::string &line) -> std::vector<std::string> {
+    std::vector<std::string> strings;
+    size_t open = line.find('"');
+    while (open != std::string::npos) {
+        size_t close = line.find('"', open + 1);
+        if (close == std::string::npos) {
+            break;
+        }
+        strings.push_back(line.substr(open + 1, close - open - 1));
+        open = line.find('"', close + 1);
+    }
+    return strings;
+}
+
+auto decode_ndjson(std::istream &in, TextWriter &writer) -> bool {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::vector<std::string> s = json_strings(line);
+        if (s.size() == 4 && s[0] == "kind" && s[2] == "name") {
+            writer.symbol(s[3]);
+        } else if (s.size() >= 3 && s[0] == "set") {
+            bool has_symbol = s.size() >= 5 && s[2] == "symbol";
+            size_t members = has_symbol ? 4 : 2;
+            if (s[members] != "members") {
+                return false;
+            }
+            writer.set(s[1], has_symbol ? s[3] : "",
+                       std::vector<std::string>(s.begin() + members + 1,
+                                                s.end()));
+        } else if (s.size() >= 3 && s[0] == "lhs" && s[2] == "rhs") {
+            writer.rule(s[1], std::vector<std::string>(s.begin() + 3, s.end()));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Fields of one binary record, read in order
+class Reader {
+  public:
+    Reader(const std::string &bytes, size_t begin, size_t end)
+        : bytes(bytes), at(begin), end(end) {}
+
+    auto u8(uint8_t &value) -> bool {
+        if (end - at < 1) {
+            return false;
+        }
+        value = static_cast<uint8_t>(bytes[at++]);
+        return true;
+    }
+
+    auto u32(uint32_t &value) -> bool {
+        if (end - at < 4) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            value |= static_cast<uint32_t>(
+                         static_cast<unsigned char>(bytes[at++]))
+                     << (8 * i);
+        }
+        return true;
+    }
+
+    auto string(std::string &value) -> bool {
+        uint32_t size = 0;
+        if (!u32(size) || end - at < size) {
+            return false;
+        }
+        value = bytes.substr(at, size);
+        at += size;
+        return true;
+    }
+
+    auto list(std::vector<std::string> &values) -> bool {
+        uint32_t count = 0;
+        if (!u32(count)) {
+            return false;
+        }
+        values.resize(count);
+        for (std::string &value : values) {
+            if (!string(value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto done() const -> bool { return at == end; }
+
+  private:
+    const std::string &bytes;
+    size_t at;
+    size_t end;
+};
+
+auto decode_binary(std::istream &in, TextWriter &writer) -> bool {
+    std::string bytes((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+    size_t at = 0;
+    while (at < bytes.size()) {
+        uint32_t size = 0;
+        Reader header(bytes, at, bytes.size());
+        if (!header.u32(size) || bytes.size() - at - 4 < size) {
+            return false;
+        }
+        at += 4;
+        Reader record(bytes, at, at + size);
+        at += size;
+
+        uint8_t type = 0;
+        std::string name;
+        std::string symbol;
+        std::vector<std::string> items;
+        if (!record.u8(type)) {
+            return false;
+        }
+        if (type == RECORD_SYMBOL) {
+            uint8_t kind = 0;
+            if (!record.u8(kind) || kind > 1 || !record.string(name)) {
+                return false;
+            }
+            writer.symbol(name);
+        } else if (type == RECORD_SET) {
+            if (!record.string(name) || !record.string(symbol) ||
+                !record.list(items)) {
+                return false;
+            }
+            writer.set(name, symbol, items);
+        } else if (type == RECORD_RULE) {
+            if (!record.string(name) || !record.list(items)) {
+                return false;
+            }
+            writer.rule(name, items);
+        } else {
+            return false;
+        }
+        if (!record.done()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int {
+    if (argc != 2 || (strcmp(argv[1], "ndjson") != 0 &&
+                      strcmp(argv[1], "binary") != 0)) {
+        std::cerr << "Usage: decode_format ndjson|binary\n";
+        return 1;
+    }
+    TextWriter writer;
+    bool ok = strcmp(argv[1], "ndjson") == 0
+                  ? decode_ndjson(std::cin, writer)
+                  : decode_binary(std::cin, writer);
+    std::cout << writer.text;
+    if (!ok) {
+        std::cerr << "Error: malformed " << argv[1] << " record\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+// Checks the Earley recognizer of Task 14 (include/earley.h) against a
+// textbook Earley recognizer with none of its shortcuts: no Leo items, no
+// nullable stepping, every set closed by rescanning it until nothing
+// changes. Both run on every sentence over the grammar's terminals up to a
+// length that keeps the count small, and on each line of a sentences file.
+//
+// Usage: earley_oracle [sentences] < grammar
+//        earley_oracle --random=N
+//
+// --random=N draws N small grammars, of two to four nonterminals and two or
+// three terminals, from a fixed seed instead of reading one. Prints up to
+// five sentences the two disagree on and exits 1 if there are any.
+#include "analysis.h"
+#include "earley.h"
+#include "ll1.h"
+#include "parser.h"
+#include "symbols.h"
+#include "types.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+const size_t MAX_SENTENCES = 20000;
+const size_t MAX_LENGTH = 8;
+const size_t REPORTED = 5;
+
+// Rule, dot, origin
+using Item = std::tuple<int, size_t, size_t>;
+
+auto naive_recognize(const InternedGrammar &grammar,
+                     const std::vector<int> &tokens) -> bool {
+    for (int token : tokens) {
+        if (token < 0 || token >= grammar.num_terms) {
+            return false;
+        }
+    }
+    std::vector<std::set<Item>> sets(tokens.size() + 1);
+    for (int rule : grammar.rules_of[grammar.start() - grammar.num_terms]) {
+        sets[0].insert(Item(rule, 0, 0));
+    }
+
+    for (size_t i = 0; i <= tokens.size(); i++) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            std::vector<Item> items(sets[i].begin(), sets[i].end());
+            for (const Item &item : items) {
+                int rule = std::get<0>(item);
+                size_t dot = std::get<1>(item);
+                size_t origin = std::get<2>(item);
+                const std::vector<int> &rhs = grammar.rule_rhs[rule];
+                if (dot == rhs.size()) {
+                    // Completer, including empty completions
+                    std::vector<Item> waiting(sets[origin].begin(),
+                                              sets[origin].end());
+                    for (const Item &w : waiting) {
+                        const std::vector<int> &w_rhs =
+                            grammar.rule_rhs[std::get<0>(w)];
+                        if (std::get<1>(w) < w_rhs.size() &&
+                            w_rhs[std::get<1>(w)] == grammar.rule_lhs[rule]) {
+                            changed |= sets[i]
+                                           .insert(Item(std::get<0>(w),
+                                                        std::get<1>(w) + 1,
+                                                        std::get<2>(w)))
+                                           .second;
+                        }
+                    }
+                } else if (grammar.is_term(rhs[dot])) {
+                    if (i < tokens.size() && rhs[dot] == tokens[i]) {
+                        sets[i + 1].insert(Item(rule, dot + 1, origin));
+                    }
+                } else {
+                    for (int predicted :
+                         grammar.rules_of[rhs[dot] - grammar.num_terms]) {
+                        changed |= sets[i].insert(Item(predicted, 0, i)).second;
+                    }
+                }
+            }
+        }
+    }
+
+    for (const Item &item : sets[tokens.size()]) {
+        int rule = std::get<0>(item);
+        if (std::get<2>(item) == 0 &&
+            std::get<1>(item) == grammar.rule_rhs[rule].size() &&
+            grammar.rule_lhs[rule] == grammar.start()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Every sentence of up to the longest length whose count, with all shorter
+// ones, stays within MAX_SENTENCES
+auto short_sentences(int num_terms) -> std::vector<std::vector<int>> {
+    std::vector<std::vector<int>> sentences(1);
+    size_t begin = 0;
+    for (size_t length = 1; length <= MAX_LENGTH && num_terms > 0; length++) {
+        size_t end = sentences.size();
+        if (end + (end - begin) * num_terms > MAX_SENTENCES) {
+            break;
+        }
+        for (size_t s = begin; s < end; s++) {
+            for (int t = 0; t < num_terms; t++) {
+                std::vector<int> longer = sentences[s];
+                longer.push_back(t);
+                sentences.push_back(longer);
+            }
+        }
+        begin = end;
+    }
+    return sentences;
+}
+
+auto sentence_text(const InternedGrammar &grammar,
+                   const std::vector<int> &tokens) -> std::string {
+    std::string text;
+    for (int token : tokens) {
+        text += (text.empty() ? "" : " ") +
+                (token >= 0 ? grammar.names[token] : std::string("?"));
+    }
+    return text.empty() ? "(empty)" : text;
+}
+
+// Number of sentences the recognizers disagree on, the first few printed
+auto compare(const Grammar &grammar,
+             const std::vector<std::vector<int>> &extra) -> size_t {
+    if (grammar.rules.empty()) {
+        return 0;
+    }
+    EarleyGrammar earley = earley::build_grammar(grammar);
+    const InternedGrammar &interned = earley.grammar;
+    EarleyRecognizer recognizer(earley);
+
+    std::vector<std::vector<int>> sentences =
+        short_sentences(interned.num_terms);
+    sentences.insert(sentences.end(), extra.begin(), extra.end());
+
+    size_t wrong = 0;
+    for (const std::vector<int> &sentence : sentences) {
+        bool expected = naive_recognize(interned, sentence);
+        if (recognizer.recognize(sentence) == expected) {
+            continue;
+        }
+        if (wrong++ < REPORTED) {
+            std::cout << sentence_text(interned, sentence) << ": expected "
+                      << (expected ? "ACCEPT" : "REJECT") << "\n";
+        }
+    }
+    return wrong;
+}
+
+auto random_grammar(std::mt19937 &rng) -> Grammar {
+    const char *names[] = {"S", "A", "B", "C", "a", "b", "c"};
+    size_t non_terms = 2 + rng() % 3;
+    size_t terms = 2 + rng() % 2;
+    std::vector<Rule> rules;
+    for (size_t lhs = 0; lhs < non_terms; lhs++) {
+        size_t alternatives = 1 + rng() % 3;
+        for (size_t a = 0; a < alternatives; a++) {
+            IDList rhs;
+            size_t length = rng() % 4;
+            for (size_t k = 0; k < length; k++) {
+                size_t symbol = rng() % (non_terms + terms);
+                if (symbol >= non_terms) { // terminals start at names[4]
+                    symbol += 4 - non_terms;
+                }
+                rhs.push_back(names[symbol]);
+            }
+            rules.emplace_back(names[lhs], std::move(rhs));
+        }
+    }
+    return analysis::grammar_from_rules(std::move(rules));
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int {
+    if (argc == 2 && strncmp(argv[1], "--random=", 9) == 0) {
+        std::mt19937 rng(2024);
+        int grammars = atoi(argv[1] + 9);
+        size_t wrong = 0;
+        for (int g = 0; g < grammars; g++) {
+            Grammar grammar = random_grammar(rng);
+            size_t here = compare(grammar, {});
+            if (here > 0) {
+                analysis::print_rules(grammar.rules, std::cout);
+                std::cout << "\n";
+            }
+            wrong += here;
+        }
+        return wrong == 0 ? 0 : 1;
+    }
+
+    Grammar grammar;
+    try {
+        Parser parser(std::cin);
+        parser.parse_input();
+        grammar = parser.generate_grammar();
+    } catch (const SyntaxError &) {
+        std::cout << "SYNTAX ERROR !!!!!!!!!!!!!!\n";
+        return 0;
+    }
+
+    std::vector<std::vector<int>> extra;
+    if (argc == 2) {
+        std::ifstream in(argv[1]);
+        extra = ll1::read_sentences(in, analysis::intern_grammar(grammar));
+    }
+    return compare(grammar, extra) == 0 ? 0 : 1;
+}
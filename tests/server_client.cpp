@@ -0,0 +1,166 @@
+// Splits the responses of the query server (include/server.h) into files so
+// test_server.sh can compare them with what a.out prints. Response n goes
+// to <dir>/<n>: its payload, or the message of an ERR response, with its
+// first word ("OK" or "ERR") in <dir>/<n>.status.
+//
+// Usage: server_client <socket> <dir> < requests
+//        server_client --stdio <dir> < responses
+//
+// With a socket, sends the request lines on one connection, each after the
+// response to the one before. With --stdio, reads what `a.out --serve=stdio`
+// wrote. Exits 1 on a response it can't read.
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Lines and fixed-size payloads from a socket or standard input
+class Reader {
+  public:
+    explicit Reader(int fd) : fd(fd) {}
+
+    auto read_line(std::string &line) -> bool {
+        size_t newline = 0;
+        while ((newline = buffer.find('\n')) == std::string::npos) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        line.assign(buffer, 0, newline);
+        buffer.erase(0, newline + 1);
+        return true;
+    }
+
+    auto read_bytes(size_t count, std::string &bytes) -> bool {
+        while (buffer.size() < count) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        bytes.assign(buffer, 0, count);
+        buffer.erase(0, count);
+        return true;
+    }
+
+    auto at_end() -> bool { return buffer.empty() && !fill(); }
+
+  private:
+    auto fill() -> bool {
+        char chunk[4096];
+        ssize_t n = 0;
+        do {
+            n = read(fd, chunk, sizeof(chunk));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd;
+    std::string buffer;
+};
+
+// Reads one response into <dir>/<n> and <dir>/<n>.status
+auto save_response(Reader &reader, const std::string &dir, int n) -> bool {
+    std::string header;
+    std::string payload;
+    if (!reader.read_line(header)) {
+        return false;
+    }
+    std::string status = header.substr(0, header.find(' '));
+    if (status == "OK") {
+        char *end = nullptr;
+        size_t size = strtoul(header.c_str() + 3, &end, 10);
+        if (*end != '\0' || !reader.read_bytes(size, payload)) {
+            return false;
+        }
+    } else if (status == "ERR") {
+        payload = header.substr(4);
+    } else {
+        return false;
+    }
+    std::string path = dir + "/" + std::to_string(n);
+    std::ofstream(path) << payload;
+    std::ofstream(path + ".status") << status << "\n";
+    return true;
+}
+
+auto connect_to(const std::string &path) -> int {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address),
+                           sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+auto send_line(int fd, const std::string &line) -> bool {
+    std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent,
+                         MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+auto main(int argc, char *argv[]) -> int {
+    if (argc != 3) {
+        std::cerr << "Usage: server_client <socket>|--stdio <dir>\n";
+        return 1;
+    }
+    const std::string dir = argv[2];
+
+    if (strcmp(argv[1], "--stdio") == 0) {
+        Reader reader(STDIN_FILENO);
+        for (int n = 1; !reader.at_end(); n++) {
+            if (!save_response(reader, dir, n)) {
+                std::cerr << "Error: malformed response " << n << "\n";
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    int fd = connect_to(argv[1]);
+    if (fd < 0) {
+        std::cerr << "Error: cannot connect to " << argv[1] << "\n";
+        return 1;
+    }
+    Reader reader(fd);
+    std::string line;
+    for (int n = 1; std::getline(std::cin, line); n++) {
+        if (!send_line(fd, line) || !save_response(reader, dir, n)) {
+            std::cerr << "Error: no response to " << line << "\n";
+            close(fd);
+            return 1;
+        }
+    }
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Checks the suffix FIRST table (include/suffix_first.h) of the grammar on
+// standard input against FIRST and nullability computed directly from the
+// sets of Tasks 2 and 3: for every rule and every position up to the end of
+// its rhs, the stored slice must be exactly FIRST of the suffix, in
+// ascending terminal ids, and the flag must say whether the suffix is
+// nullable. The node of every single symbol is checked the same way.
+//
+// Prints one line per difference, at most ten, and exits 1 if there is any.
+#include "analysis.h"
+#include "parser.h"
+#include "suffix_first.h"
+#include "symbols.h"
+#include "types.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+const size_t REPORTED = 10;
+
+struct Expected {
+    std::vector<int> first;
+    bool nullable;
+};
+
+// FIRST and nullability of symbols[start..], one symbol at a time
+auto direct(const InternedGrammar &grammar, const std::vector<int> &symbols,
+            size_t start, const SetMap &first,
+            const std::unordered_set<std::string> &nullable) -> Expected {
+    std::unordered_set<int> terms;
+    for (size_t i = start; i < symbols.size(); i++) {
+        const std::string &name = grammar.names[symbols[i]];
+        if (grammar.is_term(symbols[i])) {
+            terms.insert(symbols[i]);
+            return Expected{std::vector<int>(terms.begin(), terms.end()),
+                            false};
+        }
+        for (const std::string &term : first.at(name)) {
+            terms.insert(grammar.ids.at(term));
+        }
+        if (nullable.count(name) == 0) {
+            return Expected{std::vector<int>(terms.begin(), terms.end()),
+                            false};
+        }
+    }
+    return Expected{std::vector<int>(terms.begin(), terms.end()), true};
+}
+
+auto text(const InternedGrammar &grammar, const int *begin, const int *end)
+    -> std::string {
+    std::string res = "{";
+    for (const int *term = begin; term != end; term++) {
+        res += (term == begin ? " " : ", ") + grammar.names[*term];
+    }
+    return res + " }";
+}
+
+// Whether suffix matches expected; a difference is printed under label
+auto check(const SuffixFirstTable &table, const SuffixFirst &suffix,
+           Expected expected, const InternedGrammar &grammar,
+           const std::string &label, size_t &wrong) -> bool {
+    std::sort(expected.first.begin(), expected.first.end());
+    const int *begin = table.first_begin(suffix);
+    const int *end = table.first_end(suffix);
+    if (std::vector<int>(begin, end) == expected.first &&
+        suffix.nullable == expected.nullable) {
+        return true;
+    }
+    if (wrong++ < REPORTED) {
+        std::cout << label << ": FIRST " << text(grammar, begin, end)
+                  << (suffix.nullable ? " nullable" : "") << ", expected "
+                  << text(grammar, expected.first.data(),
+                          expected.first.data() + expected.first.size())
+                  << (expected.nullable ? " nullable" : "") << "\n";
+    }
+    return false;
+}
+
+} // namespace
+
+auto main() -> int {
+    Grammar grammar;
+    try {
+        Parser parser(std::cin);
+        parser.parse_input();
+        grammar = parser.generate_grammar();
+    } catch (const SyntaxError &) {
+        std::cout << "SYNTAX ERROR !!!!!!!!!!!!!!\n";
+        return 0;
+    }
+
+    auto nullable = analysis::calc_nullable(grammar);
+    auto first = analysis::calc_first(grammar);
+    const InternedGrammar interned = analysis::intern_grammar(grammar);
+    const SuffixFirstTable table =
+        analysis::build_suffix_first(interned, first, nullable);
+
+    size_t wrong = 0;
+    for (size_t r = 0; r < interned.rule_rhs.size(); r++) {
+        const std::vector<int> &rhs = interned.rule_rhs[r];
+        for (size_t i = 0; i <= rhs.size(); i++) {
+            check(table, table.at(r, i),
+                  direct(interned, rhs, i, first, nullable), interned,
+                  grammar.rules[r].to_string() + " from " + std::to_string(i),
+                  wrong);
+        }
+    }
+    for (int symbol = 0; symbol < interned.num_symbols(); symbol++) {
+        check(table, table.of_symbol(symbol),
+              direct(interned, std::vector<int>(1, symbol), 0, first,
+                     nullable),
+              interned, interned.names[symbol], wrong);
+    }
+    return wrong == 0 ? 0 : 1;
+}